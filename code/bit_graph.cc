@@ -1,6 +0,0 @@
-/* vim: set sw=4 sts=4 et foldmethod=syntax : */
-
-#include "bit_graph.hh"
-
-GraphTooBig::GraphTooBig() throw () = default;
-
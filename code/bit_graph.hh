@@ -3,60 +3,280 @@
 #ifndef GUARD_BIT_GRAPH_HH
 #define GUARD_BIT_GRAPH_HH 1
 
+#include "bit_kernels.hh"
+
 #include <array>
 #include <vector>
 #include <tuple>
 #include <utility>
 #include <algorithm>
 
-/// We'll use an array of unsigned long longs to represent our bits.
-using BitWord = unsigned long long;
-
 /// Number of bits per word.
 static const constexpr int bits_per_word = sizeof(BitWord) * 8;
 
+/**
+ * Larger bitsets keep track of which of their words might be non-zero.
+ */
+constexpr unsigned bit_set_range_min_words = 128;
+
+/**
+ * Used as the number of words for a bitset or bitgraph whose size is only
+ * known at runtime.
+ */
+constexpr unsigned runtime_sized_words = 0;
+
+/**
+ * The words of a FixedBitSet, which for a fixed size just live inside it.
+ */
+template <unsigned words_>
+class BitSetWords
+{
+    private:
+        std::array<BitWord, words_> _words;
+
+    public:
+        auto size() const -> unsigned
+        {
+            return words_;
+        }
+
+        /**
+         * Make sure we have at least n words. We always do.
+         */
+        auto reserve(unsigned) -> void
+        {
+        }
+
+        auto data() -> BitWord *
+        {
+            return _words.data();
+        }
+
+        auto data() const -> const BitWord *
+        {
+            return _words.data();
+        }
+
+        auto operator[] (unsigned i) -> BitWord &
+        {
+            return _words[i];
+        }
+
+        auto operator[] (unsigned i) const -> const BitWord &
+        {
+            return _words[i];
+        }
+};
+
+/**
+ * A runtime sized bitset's words live on the heap, and grow as needed.
+ * Growing never shrinks, so once a set is reused it stops allocating.
+ */
+template <>
+class BitSetWords<runtime_sized_words>
+{
+    private:
+        std::vector<BitWord> _words;
+
+    public:
+        auto size() const -> unsigned
+        {
+            return _words.size();
+        }
+
+        /**
+         * Make sure we have at least n words. New words hold junk.
+         */
+        auto reserve(unsigned n) -> void
+        {
+            if (_words.size() < n)
+                _words.resize(n);
+        }
+
+        auto data() -> BitWord *
+        {
+            return _words.data();
+        }
+
+        auto data() const -> const BitWord *
+        {
+            return _words.data();
+        }
+
+        auto operator[] (unsigned i) -> BitWord &
+        {
+            return _words[i];
+        }
+
+        auto operator[] (unsigned i) const -> const BitWord &
+        {
+            return _words[i];
+        }
+};
+
+/**
+ * The range of words in a FixedBitSet which might be non-zero.
+ */
+template <unsigned words_, bool track_ = (runtime_sized_words == words_ || words_ >= bit_set_range_min_words)>
+class BitSetRange
+{
+    private:
+        unsigned _lo = 0, _hi = 0;
+
+    public:
+        auto lo() const -> unsigned
+        {
+            return _lo;
+        }
+
+        auto hi() const -> unsigned
+        {
+            return _hi;
+        }
+
+        auto set(unsigned lo, unsigned hi) -> void
+        {
+            _lo = lo;
+            _hi = hi;
+        }
+};
+
+/**
+ * Smaller bitsets always use every word, because the bookkeeping costs
+ * more than it saves.
+ */
+template <unsigned words_>
+class BitSetRange<words_, false>
+{
+    public:
+        constexpr auto lo() const -> unsigned
+        {
+            return 0;
+        }
+
+        constexpr auto hi() const -> unsigned
+        {
+            return words_;
+        }
+
+        auto set(unsigned, unsigned) -> void
+        {
+        }
+};
+
 /**
  * A bitset with a fixed maximum size. This only provides the operations
  * we actually use in the bitset algorithms: it's more readable this way
  * than doing all the bit voodoo inline.
  *
+ * Large sets also keep track of a range of words outside of which every
+ * bit is off, and only ever look at words inside that range. Words
+ * outside of it hold junk. Deep in the search our sets are very sparse, so
+ * this saves a lot of work on large graphs. Most operations keep the range
+ * tight, so that the first and last words in it are non-zero, but we don't
+ * rely upon this.
+ *
+ * If words_ is runtime_sized_words, there is no maximum size: we only hold
+ * as many words as our range has ever needed.
+ *
  * Indices start at 0.
  */
 template <unsigned words_>
 class FixedBitSet
 {
     private:
-        using Bits = std::array<BitWord, words_>;
+        using Bits = BitSetWords<words_>;
+        using Range = BitSetRange<words_>;
 
-        Bits _bits = {{ }};
+        static constexpr bool _tracks_range = runtime_sized_words == words_ || words_ >= bit_set_range_min_words;
+
+        Bits _bits;
+        Range _range;
+
+        /**
+         * Make the range include word w, zeroing anything we add to it.
+         */
+        auto _cover(unsigned w) -> void
+        {
+            _bits.reserve(w + 1);
+            unsigned lo = _range.lo(), hi = _range.hi();
+            if (lo == hi) {
+                _bits[w] = 0;
+                _range.set(w, w + 1);
+            }
+            else if (w < lo) {
+                std::fill(_bits.data() + w, _bits.data() + lo, 0);
+                _range.set(w, hi);
+            }
+            else if (w >= hi) {
+                std::fill(_bits.data() + hi, _bits.data() + w + 1, 0);
+                _range.set(lo, w + 1);
+            }
+        }
+
+        /**
+         * Shrink the range past any zero words at either end.
+         */
+        auto _trim() -> void
+        {
+            if (! _tracks_range)
+                return;
+
+            unsigned lo = _range.lo(), hi = _range.hi();
+            while (lo < hi && 0 == _bits[lo])
+                ++lo;
+            while (lo < hi && 0 == _bits[hi - 1])
+                --hi;
+            _range.set(lo, hi);
+        }
 
     public:
+        FixedBitSet()
+        {
+            if (! _tracks_range)
+                std::fill(_bits.data(), _bits.data() + _bits.size(), 0);
+        }
+
+        FixedBitSet(const FixedBitSet<words_> & other) :
+            _range(other._range)
+        {
+            _bits.reserve(_range.hi());
+            std::copy(other._bits.data() + _range.lo(), other._bits.data() + _range.hi(), _bits.data() + _range.lo());
+        }
+
+        auto operator= (const FixedBitSet<words_> & other) -> FixedBitSet<words_> &
+        {
+            _range = other._range;
+            _bits.reserve(_range.hi());
+            std::copy(other._bits.data() + _range.lo(), other._bits.data() + _range.hi(), _bits.data() + _range.lo());
+            return *this;
+        }
+
         /**
          * Set a given bit 'on'.
          */
         auto set(int a) -> void
         {
+            _cover(a / bits_per_word);
+
             // The 1 does have to be of type BitWord. If we just specify a
             // literal, it ends up being an int, and it isn't converted
             // upwards until after the shift is done.
             _bits[a / bits_per_word] |= (BitWord{ 1 } << (a % bits_per_word));
         }
 
-        /**
-         * Set a given bit 'on'.
-         */
-        auto set_atomic(int a) -> void
-        {
-            // we don't have std::atomic_concurrent_view yet...
-            __sync_or_and_fetch(&_bits[a / bits_per_word], (BitWord{ 1 } << (a % bits_per_word)));
-        }
-
         /**
          * Set a given bit 'off'.
          */
         auto unset(int a) -> void
         {
-            _bits[a / bits_per_word] &= ~(BitWord{ 1 } << (a % bits_per_word));
+            unsigned w = a / bits_per_word;
+            if (w < _range.lo() || w >= _range.hi())
+                return;
+
+            _bits[w] &= ~(BitWord{ 1 } << (a % bits_per_word));
+            if (0 == _bits[w] && (w == _range.lo() || w + 1 == _range.hi()))
+                _trim();
         }
 
         /**
@@ -64,9 +284,14 @@ class FixedBitSet
          */
         auto set_up_to(int size) -> void
         {
-            unset_all();
-            for (int i = 0 ; i < size ; ++i)
-                set(i);
+            unsigned full_words = size / bits_per_word, used_words = (size + bits_per_word - 1) / bits_per_word;
+            _bits.reserve(used_words);
+            std::fill(_bits.data(), _bits.data() + full_words, ~BitWord{ 0 });
+            if (used_words != full_words)
+                _bits[full_words] = (BitWord{ 1 } << (size % bits_per_word)) - 1;
+            if (! _tracks_range)
+                std::fill(_bits.data() + used_words, _bits.data() + _bits.size(), 0);
+            _range.set(0, used_words);
         }
 
         /**
@@ -74,8 +299,22 @@ class FixedBitSet
          */
         auto unset_all() -> void
         {
-            for (unsigned i = 0 ; i < words_ ; ++i)
-                _bits[i] = 0;
+            if (! _tracks_range)
+                std::fill(_bits.data(), _bits.data() + _bits.size(), 0);
+            _range.set(0, 0);
+        }
+
+        /**
+         * Copy in the first n words from raw storage, and clear the rest.
+         */
+        auto assign_words(const BitWord * words, unsigned n) -> void
+        {
+            _bits.reserve(n);
+            std::copy(words, words + n, _bits.data());
+            if (! _tracks_range)
+                std::fill(_bits.data() + n, _bits.data() + _bits.size(), 0);
+            _range.set(0, n);
+            _trim();
         }
 
         /**
@@ -83,10 +322,17 @@ class FixedBitSet
          */
         auto complement_up_to(int size) -> void
         {
-            for (unsigned i = 0 ; i < words_ ; ++i)
+            unsigned used_words = (size + bits_per_word - 1) / bits_per_word;
+            if (0 == used_words)
+                return;
+
+            _cover(0);
+            _cover(used_words - 1);
+            for (unsigned i = 0 ; i < used_words ; ++i)
                 _bits[i] = ~_bits[i];
-            for (unsigned i = size ; i < words_ * bits_per_word ; ++i)
-                unset(i);
+            for (unsigned i = size ; i < used_words * bits_per_word ; ++i)
+                _bits[i / bits_per_word] &= ~(BitWord{ 1 } << (i % bits_per_word));
+            _trim();
         }
 
         /**
@@ -94,7 +340,8 @@ class FixedBitSet
          */
         auto test(int a) const -> bool
         {
-            return _bits[a / bits_per_word] & (BitWord{ 1 } << (a % bits_per_word));
+            unsigned w = a / bits_per_word;
+            return w >= _range.lo() && w < _range.hi() && (_bits[w] & (BitWord{ 1 } << (a % bits_per_word)));
         }
 
         /**
@@ -102,9 +349,13 @@ class FixedBitSet
          */
         auto popcount() const -> unsigned
         {
+            unsigned lo = _range.lo(), hi = _range.hi();
+            if (hi - lo >= bit_kernels_min_words)
+                return bit_kernels.popcount(_bits.data() + lo, hi - lo);
+
             unsigned result = 0;
-            for (auto & p : _bits)
-                result += __builtin_popcountll(p);
+            for (unsigned i = lo ; i < hi ; ++i)
+                result += __builtin_popcountll(_bits[i]);
             return result;
         }
 
@@ -113,8 +364,12 @@ class FixedBitSet
          */
         auto empty() const -> bool
         {
-            for (auto & p : _bits)
-                if (0 != p)
+            unsigned lo = _range.lo(), hi = _range.hi();
+            if (hi - lo >= bit_kernels_min_words)
+                return bit_kernels.empty(_bits.data() + lo, hi - lo);
+
+            for (unsigned i = lo ; i < hi ; ++i)
+                if (0 != _bits[i])
                     return false;
             return true;
         }
@@ -124,8 +379,48 @@ class FixedBitSet
          */
         auto intersect_with(const FixedBitSet<words_> & other) -> void
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
-                _bits[i] = _bits[i] & other._bits[i];
+            unsigned lo = std::max(_range.lo(), other._range.lo()), hi = std::min(_range.hi(), other._range.hi());
+            if (lo >= hi) {
+                unset_all();
+                return;
+            }
+            _range.set(lo, hi);
+
+            if (hi - lo >= bit_kernels_min_words)
+                bit_kernels.intersect(_bits.data() + lo, other._bits.data() + lo, hi - lo);
+            else
+                for (unsigned i = lo ; i < hi ; ++i)
+                    _bits[i] = _bits[i] & other._bits[i];
+
+            _trim();
+        }
+
+        /**
+         * Become the intersection of two sets, and return how many bits
+         * are on. This saves a copy and a second pass over the words when
+         * we want both.
+         */
+        auto assign_intersection(const FixedBitSet<words_> & a, const FixedBitSet<words_> & b) -> unsigned
+        {
+            unsigned lo = std::max(a._range.lo(), b._range.lo()), hi = std::min(a._range.hi(), b._range.hi());
+            if (lo >= hi) {
+                unset_all();
+                return 0;
+            }
+            _range.set(lo, hi);
+            _bits.reserve(hi);
+
+            unsigned result = 0;
+            if (hi - lo >= bit_kernels_min_words)
+                result = bit_kernels.intersect_and_count(_bits.data() + lo, a._bits.data() + lo, b._bits.data() + lo, hi - lo);
+            else
+                for (unsigned i = lo ; i < hi ; ++i) {
+                    _bits[i] = a._bits[i] & b._bits[i];
+                    result += __builtin_popcountll(_bits[i]);
+                }
+
+            _trim();
+            return result;
         }
 
         /**
@@ -133,17 +428,45 @@ class FixedBitSet
          */
         auto union_with(const FixedBitSet<words_> & other) -> void
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
+            unsigned lo = other._range.lo(), hi = other._range.hi();
+            if (lo == hi)
+                return;
+
+            _cover(lo);
+            _cover(hi - 1);
+            for (unsigned i = lo ; i < hi ; ++i)
                 _bits[i] = _bits[i] | other._bits[i];
         }
 
         /**
-         * Intersect with the complement of another set.
+         * Intersect with the complement of another set, and return whether
+         * any bits are left on.
          */
-        auto intersect_with_complement(const FixedBitSet<words_> & other) -> void
+        auto intersect_with_complement(const FixedBitSet<words_> & other) -> bool
         {
-            for (typename Bits::size_type i = 0 ; i < words_ ; ++i)
-                _bits[i] = _bits[i] & ~other._bits[i];
+            unsigned lo = std::max(_range.lo(), other._range.lo()), hi = std::min(_range.hi(), other._range.hi());
+            if (lo >= hi)
+                return ! empty();
+
+            bool any = false;
+            if (hi - lo >= bit_kernels_min_words)
+                any = bit_kernels.intersect_with_complement(_bits.data() + lo, other._bits.data() + lo, hi - lo);
+            else {
+                BitWord any_word = 0;
+                for (unsigned i = lo ; i < hi ; ++i) {
+                    _bits[i] = _bits[i] & ~other._bits[i];
+                    any_word |= _bits[i];
+                }
+                any = 0 != any_word;
+            }
+
+            if (! _tracks_range)
+                return any;
+
+            /* we might not have touched every word in our range, but once
+             * we're trimmed it's empty exactly when the range is */
+            _trim();
+            return _range.lo() != _range.hi();
         }
 
         /**
@@ -152,7 +475,7 @@ class FixedBitSet
          */
         auto first_set_bit() const -> int
         {
-            for (typename Bits::size_type i = 0 ; i < _bits.size() ; ++i) {
+            for (unsigned i = _range.lo() ; i < _range.hi() ; ++i) {
                 int b = __builtin_ffsll(_bits[i]);
                 if (0 != b)
                     return i * bits_per_word + b - 1;
@@ -166,7 +489,7 @@ class FixedBitSet
          */
         auto last_set_bit() const -> int
         {
-            for (int i = _bits.size() - 1 ; i >= 0 ; --i) {
+            for (int i = int(_range.hi()) - 1 ; i >= int(_range.lo()) ; --i) {
                 if (0 == _bits[i])
                     continue;
 
@@ -176,23 +499,92 @@ class FixedBitSet
             return -1;
         }
 
-        auto operator== (const FixedBitSet<words_> & other) const -> bool
+        /**
+         * Call f with the index of every set ('on') bit, in ascending
+         * order.
+         */
+        template <typename F_>
+        auto for_each_set_bit(const F_ & f) const -> void
         {
-            if (_bits.size() != other._bits.size())
-                return false;
+            for (unsigned i = _range.lo() ; i < _range.hi() ; ++i)
+                for (BitWord w = _bits[i] ; 0 != w ; w &= w - 1)
+                    f(i * bits_per_word + __builtin_ctzll(w));
+        }
+
+        /**
+         * Greedily take an independent set from this set, in ascending
+         * order, calling f with each vertex taken. After taking v, we drop
+         * everything in rows[v], and at the end we are empty.
+         *
+         * Everything before the word holding v is already zero, so we keep
+         * a cursor on that word and only mask from there onwards. This
+         * gives the same vertices as repeatedly calling first_set_bit(),
+         * unset() and intersect_with_complement(), without rescanning from
+         * the start each time.
+         */
+        template <typename F_>
+        auto take_independent_set(const std::vector<FixedBitSet<words_> > & rows, const F_ & f) -> void
+        {
+            unsigned hi = _range.hi();
+            for (unsigned w = _range.lo() ; w < hi ; ++w) {
+                // the word under the cursor lives in a register until we're
+                // done with it
+                for (BitWord word = _bits[w] ; 0 != word ; ) {
+                    int v = w * bits_per_word + __builtin_ctzll(word);
+                    word &= word - 1;
+                    f(v);
+
+                    const auto & row = rows[v];
+                    if (w >= row._range.lo() && w < row._range.hi())
+                        word &= ~row._bits[w];
+
+                    unsigned row_lo = std::max(w + 1, row._range.lo()), row_hi = std::min(hi, row._range.hi());
+                    if (row_hi <= row_lo)
+                        continue;
+
+                    bool any_left = false;
+                    if (row_hi - row_lo >= bit_kernels_min_words)
+                        any_left = bit_kernels.intersect_with_complement(_bits.data() + row_lo, row._bits.data() + row_lo, row_hi - row_lo);
+                    else {
+                        BitWord any_word = 0;
+                        for (unsigned i = row_lo ; i < row_hi ; ++i) {
+                            _bits[i] = _bits[i] & ~row._bits[i];
+                            any_word |= _bits[i];
+                        }
+                        any_left = 0 != any_word;
+                    }
+
+                    // if we just masked everything after the cursor, we
+                    // might know that we're finished
+                    if (0 == word && ! any_left && row_lo == w + 1 && row_hi == hi)
+                        hi = w + 1;
+                }
+                _bits[w] = 0;
+            }
+
+            // every word is zero now, so there's nothing to clear
+            _range.set(0, 0);
+        }
 
-            for (typename Bits::size_type i = 0 ; i < _bits.size() ; ++i)
-                if (_bits[i] != other._bits[i])
+        auto operator== (const FixedBitSet<words_> & other) const -> bool
+        {
+            unsigned lo = std::min(_range.lo(), other._range.lo()), hi = std::max(_range.hi(), other._range.hi());
+            for (unsigned i = lo ; i < hi ; ++i) {
+                BitWord mine = (i >= _range.lo() && i < _range.hi()) ? _bits[i] : 0;
+                BitWord theirs = (i >= other._range.lo() && i < other._range.hi()) ? other._bits[i] : 0;
+                if (mine != theirs)
                     return false;
+            }
 
             return true;
         }
 };
 
 /**
- * A bitgraph with a fixed maximum size. In effect this is an adjacency
- * matrix representation. This only provides the operations we actually use
- * in the bitset algorithms.
+ * A bitgraph with a fixed maximum size, or with no maximum if size_ is
+ * runtime_sized_words. In effect this is an adjacency matrix
+ * representation. This only provides the operations we actually use in
+ * the bitset algorithms.
  *
  * Indices start at 0.
  */
@@ -215,7 +607,7 @@ class FixedBitGraph
         }
 
         /**
-         * Change our actual size. Must be below the maximum.
+         * Change our actual size. Must be below the maximum, if we have one.
          */
         auto resize(int size) -> void
         {
@@ -233,12 +625,12 @@ class FixedBitGraph
         }
 
         /**
-         * Add an edge from a to b (and from b to a).
+         * Copy a whole row from raw storage, one bit per vertex. Only the
+         * first n words are given.
          */
-        auto add_edge_atomic(int a, int b) -> void
+        auto assign_row_words(int row, const BitWord * words, unsigned n) -> void
         {
-            _adjacency[a].set_atomic(b);
-            _adjacency[b].set_atomic(a);
+            _adjacency[row].assign_words(words, n);
         }
 
         /**
@@ -265,13 +657,32 @@ class FixedBitGraph
             p.intersect_with(_adjacency[row]);
         }
 
+        /**
+         * Set the supplied bitset to the intersection of p and a particular
+         * row, and return how many bits are on in it.
+         */
+        auto intersect_row_into(int row, const FixedBitSet<size_> & p, FixedBitSet<size_> & result) const -> unsigned
+        {
+            return result.assign_intersection(p, _adjacency[row]);
+        }
+
         /**
          * Intersect the supplied bitset with the complement of a
-         * particular row.
+         * particular row, and return whether anything is left.
          */
-        auto intersect_with_row_complement(int row, FixedBitSet<size_> & p) const -> void
+        auto intersect_with_row_complement(int row, FixedBitSet<size_> & p) const -> bool
         {
-            p.intersect_with_complement(_adjacency[row]);
+            return p.intersect_with_complement(_adjacency[row]);
+        }
+
+        /**
+         * Greedily take an independent set from q, in ascending order,
+         * calling f with each vertex taken. q is left empty.
+         */
+        template <typename F_>
+        auto take_independent_set(FixedBitSet<size_> & q, const F_ & f) const -> void
+        {
+            q.take_independent_set(_adjacency, f);
         }
 
         /**
@@ -294,20 +705,4 @@ class FixedBitGraph
         }
 };
 
-/**
- * We have to decide at compile time what the largest graph we'll support
- * is.
- */
-constexpr auto max_graph_words __attribute__((unused)) = 1024;
-
-/**
- * Thrown if we exceed max_graph_words.
- */
-class GraphTooBig :
-    public std::exception
-{
-    public:
-        GraphTooBig() throw ();
-};
-
 #endif
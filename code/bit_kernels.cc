@@ -0,0 +1,310 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "bit_kernels.hh"
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace
+{
+    auto intersect_scalar(BitWord * a, const BitWord * b, unsigned n) -> void
+    {
+        for (unsigned i = 0 ; i < n ; ++i)
+            a[i] &= b[i];
+    }
+
+    auto intersect_and_count_scalar(BitWord * r, const BitWord * a, const BitWord * b, unsigned n) -> unsigned
+    {
+        unsigned result = 0;
+        for (unsigned i = 0 ; i < n ; ++i) {
+            r[i] = a[i] & b[i];
+            result += __builtin_popcountll(r[i]);
+        }
+        return result;
+    }
+
+    auto intersect_with_complement_scalar(BitWord * a, const BitWord * b, unsigned n) -> bool
+    {
+        BitWord any = 0;
+        for (unsigned i = 0 ; i < n ; ++i) {
+            a[i] &= ~b[i];
+            any |= a[i];
+        }
+        return 0 != any;
+    }
+
+    auto popcount_scalar(const BitWord * a, unsigned n) -> unsigned
+    {
+        unsigned result = 0;
+        for (unsigned i = 0 ; i < n ; ++i)
+            result += __builtin_popcountll(a[i]);
+        return result;
+    }
+
+    auto empty_scalar(const BitWord * a, unsigned n) -> bool
+    {
+        for (unsigned i = 0 ; i < n ; ++i)
+            if (0 != a[i])
+                return false;
+        return true;
+    }
+
+    const BitKernels scalar_kernels{ "scalar", intersect_scalar, intersect_and_count_scalar, intersect_with_complement_scalar,
+        popcount_scalar, empty_scalar };
+
+#if defined(__x86_64__)
+    __attribute__((target("avx2")))
+    auto intersect_avx2(BitWord * a, const BitWord * b, unsigned n) -> void
+    {
+        unsigned i = 0;
+        for ( ; i + 4 <= n ; i += 4) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), _mm256_and_si256(x, y));
+        }
+        for ( ; i < n ; ++i)
+            a[i] &= b[i];
+    }
+
+    __attribute__((target("avx2")))
+    auto intersect_with_complement_avx2(BitWord * a, const BitWord * b, unsigned n) -> bool
+    {
+        auto any = _mm256_setzero_si256();
+        unsigned i = 0;
+        for ( ; i + 4 <= n ; i += 4) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            auto r = _mm256_andnot_si256(y, x);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), r);
+            any = _mm256_or_si256(any, r);
+        }
+
+        BitWord any_tail = 0;
+        for ( ; i < n ; ++i) {
+            a[i] &= ~b[i];
+            any_tail |= a[i];
+        }
+        return 0 != any_tail || ! _mm256_testz_si256(any, any);
+    }
+
+    /* AVX2 has no vector popcount, so we count nibbles with a shuffle
+     * lookup and sum bytes with sad (Mula's method). */
+    __attribute__((target("avx2")))
+    auto popcount_avx2_vector(__m256i x) -> __m256i
+    {
+        const auto lookup = _mm256_setr_epi8(
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const auto low_mask = _mm256_set1_epi8(0x0f);
+
+        auto lo = _mm256_and_si256(x, low_mask);
+        auto hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+        auto counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    }
+
+    __attribute__((target("avx2")))
+    auto sum_avx2_lanes(__m256i totals) -> unsigned
+    {
+        return _mm256_extract_epi64(totals, 0) + _mm256_extract_epi64(totals, 1)
+            + _mm256_extract_epi64(totals, 2) + _mm256_extract_epi64(totals, 3);
+    }
+
+    __attribute__((target("avx2,popcnt")))
+    auto popcount_avx2(const BitWord * a, unsigned n) -> unsigned
+    {
+        auto totals = _mm256_setzero_si256();
+        unsigned i = 0;
+        for ( ; i + 4 <= n ; i += 4)
+            totals = _mm256_add_epi64(totals, popcount_avx2_vector(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i))));
+
+        unsigned result = sum_avx2_lanes(totals);
+        for ( ; i < n ; ++i)
+            result += __builtin_popcountll(a[i]);
+        return result;
+    }
+
+    __attribute__((target("avx2,popcnt")))
+    auto intersect_and_count_avx2(BitWord * r, const BitWord * a, const BitWord * b, unsigned n) -> unsigned
+    {
+        auto totals = _mm256_setzero_si256();
+        unsigned i = 0;
+        for ( ; i + 4 <= n ; i += 4) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            auto z = _mm256_and_si256(x, y);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), z);
+            totals = _mm256_add_epi64(totals, popcount_avx2_vector(z));
+        }
+
+        unsigned result = sum_avx2_lanes(totals);
+        for ( ; i < n ; ++i) {
+            r[i] = a[i] & b[i];
+            result += __builtin_popcountll(r[i]);
+        }
+        return result;
+    }
+
+    __attribute__((target("avx2")))
+    auto empty_avx2(const BitWord * a, unsigned n) -> bool
+    {
+        unsigned i = 0;
+        for ( ; i + 4 <= n ; i += 4) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            if (! _mm256_testz_si256(x, x))
+                return false;
+        }
+        for ( ; i < n ; ++i)
+            if (0 != a[i])
+                return false;
+        return true;
+    }
+
+    const BitKernels avx2_kernels{ "avx2", intersect_avx2, intersect_and_count_avx2, intersect_with_complement_avx2,
+        popcount_avx2, empty_avx2 };
+
+    /* With AVX-512, the tail can be handled with a masked load. We use
+     * ternary logic (0x30 is a & ~b) for and-not, and sum lanes by hand,
+     * because the intrinsics for these upset -Wuninitialized on some
+     * compilers. */
+    __attribute__((target("avx512f")))
+    auto tail_mask(unsigned n) -> __mmask8
+    {
+        return (1u << n) - 1;
+    }
+
+    __attribute__((target("avx512f")))
+    auto intersect_avx512(BitWord * a, const BitWord * b, unsigned n) -> void
+    {
+        unsigned i = 0;
+        for ( ; i + 8 <= n ; i += 8) {
+            auto x = _mm512_loadu_si512(a + i);
+            auto y = _mm512_loadu_si512(b + i);
+            _mm512_storeu_si512(a + i, _mm512_and_si512(x, y));
+        }
+        if (i < n) {
+            auto m = tail_mask(n - i);
+            auto x = _mm512_maskz_loadu_epi64(m, a + i);
+            auto y = _mm512_maskz_loadu_epi64(m, b + i);
+            _mm512_mask_storeu_epi64(a + i, m, _mm512_and_si512(x, y));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    auto intersect_with_complement_avx512(BitWord * a, const BitWord * b, unsigned n) -> bool
+    {
+        auto any = _mm512_setzero_si512();
+        unsigned i = 0;
+        for ( ; i + 8 <= n ; i += 8) {
+            auto x = _mm512_loadu_si512(a + i);
+            auto y = _mm512_loadu_si512(b + i);
+            auto r = _mm512_ternarylogic_epi64(x, y, y, 0x30);
+            _mm512_storeu_si512(a + i, r);
+            any = _mm512_or_si512(any, r);
+        }
+        if (i < n) {
+            auto m = tail_mask(n - i);
+            auto x = _mm512_maskz_loadu_epi64(m, a + i);
+            auto y = _mm512_maskz_loadu_epi64(m, b + i);
+            auto r = _mm512_ternarylogic_epi64(x, y, y, 0x30);
+            _mm512_mask_storeu_epi64(a + i, m, r);
+            any = _mm512_or_si512(any, r);
+        }
+        return 0 != _mm512_test_epi64_mask(any, any);
+    }
+
+    __attribute__((target("avx512f")))
+    auto sum_avx512_lanes(__m512i totals) -> unsigned
+    {
+        alignas(64) BitWord lanes[8];
+        _mm512_store_si512(lanes, totals);
+        unsigned result = 0;
+        for (auto & l : lanes)
+            result += l;
+        return result;
+    }
+
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    auto popcount_avx512(const BitWord * a, unsigned n) -> unsigned
+    {
+        auto totals = _mm512_setzero_si512();
+        unsigned i = 0;
+        for ( ; i + 8 <= n ; i += 8)
+            totals = _mm512_add_epi64(totals, _mm512_popcnt_epi64(_mm512_loadu_si512(a + i)));
+        if (i < n)
+            totals = _mm512_add_epi64(totals, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail_mask(n - i), a + i)));
+
+        return sum_avx512_lanes(totals);
+    }
+
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    auto intersect_and_count_avx512(BitWord * r, const BitWord * a, const BitWord * b, unsigned n) -> unsigned
+    {
+        auto totals = _mm512_setzero_si512();
+        unsigned i = 0;
+        for ( ; i + 8 <= n ; i += 8) {
+            auto z = _mm512_and_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+            _mm512_storeu_si512(r + i, z);
+            totals = _mm512_add_epi64(totals, _mm512_popcnt_epi64(z));
+        }
+        if (i < n) {
+            auto m = tail_mask(n - i);
+            auto z = _mm512_and_si512(_mm512_maskz_loadu_epi64(m, a + i), _mm512_maskz_loadu_epi64(m, b + i));
+            _mm512_mask_storeu_epi64(r + i, m, z);
+            totals = _mm512_add_epi64(totals, _mm512_popcnt_epi64(z));
+        }
+
+        return sum_avx512_lanes(totals);
+    }
+
+    __attribute__((target("avx512f")))
+    auto empty_avx512(const BitWord * a, unsigned n) -> bool
+    {
+        unsigned i = 0;
+        for ( ; i + 8 <= n ; i += 8) {
+            auto x = _mm512_loadu_si512(a + i);
+            if (0 != _mm512_test_epi64_mask(x, x))
+                return false;
+        }
+        if (i < n) {
+            auto x = _mm512_maskz_loadu_epi64(tail_mask(n - i), a + i);
+            if (0 != _mm512_test_epi64_mask(x, x))
+                return false;
+        }
+        return true;
+    }
+
+    const BitKernels avx512_kernels{ "avx512", intersect_avx512, intersect_and_count_avx512, intersect_with_complement_avx512,
+        popcount_avx512, empty_avx512 };
+#endif
+
+    auto find_kernels(const std::string & name) -> const BitKernels *
+    {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        bool have_avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+        bool have_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+
+        if (("best" == name || "avx512" == name) && have_avx512)
+            return &avx512_kernels;
+        if (("best" == name || "avx2" == name) && have_avx2)
+            return &avx2_kernels;
+#endif
+        if ("best" == name || "scalar" == name)
+            return &scalar_kernels;
+        return nullptr;
+    }
+}
+
+BitKernels bit_kernels = *find_kernels("best");
+
+auto select_bit_kernels(const std::string & name) -> bool
+{
+    auto kernels = find_kernels(name);
+    if (! kernels)
+        return false;
+    bit_kernels = *kernels;
+    return true;
+}
+
@@ -0,0 +1,54 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#ifndef CODE_GUARD_BIT_KERNELS_HH
+#define CODE_GUARD_BIT_KERNELS_HH 1
+
+#include <string>
+
+/// We'll use an array of unsigned long longs to represent our bits.
+using BitWord = unsigned long long;
+
+/**
+ * Bitset operations over arrays of words, in several vectorised versions.
+ * Which version we use is decided at runtime, based upon what the CPU
+ * supports, so that one binary runs well everywhere.
+ */
+struct BitKernels
+{
+    const char * name;
+
+    /// a &= b, for n words.
+    void (* intersect)(BitWord * a, const BitWord * b, unsigned n);
+
+    /// r = a & b, for n words, returning how many bits are on in r.
+    unsigned (* intersect_and_count)(BitWord * r, const BitWord * a, const BitWord * b, unsigned n);
+
+    /// a &= ~b, for n words, returning whether any bits are left on.
+    bool (* intersect_with_complement)(BitWord * a, const BitWord * b, unsigned n);
+
+    /// How many bits are on in n words?
+    unsigned (* popcount)(const BitWord * a, unsigned n);
+
+    /// Are all n words zero?
+    bool (* empty)(const BitWord * a, unsigned n);
+};
+
+/**
+ * The kernels in use. Initially, the best that this CPU supports.
+ */
+extern BitKernels bit_kernels;
+
+/**
+ * Bitsets with fewer words than this are handled inline, because the
+ * overhead of an indirect call outweighs any benefit.
+ */
+constexpr unsigned bit_kernels_min_words = 8;
+
+/**
+ * Switch to a particular set of kernels (scalar, avx2 or avx512), or to
+ * the best available (best). Returns false if they are unknown or not
+ * supported by this CPU.
+ */
+auto select_bit_kernels(const std::string & name) -> bool;
+
+#endif
@@ -0,0 +1,153 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "checkpoint.hh"
+#include "graph.hh"
+#include "bit_graph.hh"
+
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+CheckpointFileError::CheckpointFileError(const std::string & filename, const std::string & message) throw () :
+    _what("Error with checkpoint file '" + filename + "': " + message)
+{
+}
+
+auto CheckpointFileError::what() const throw () -> const char *
+{
+    return _what.c_str();
+}
+
+namespace
+{
+    /* Checkpoints are text, and look like this:
+     *
+     *   checkpoint <graph size>
+     *   nodes <nodes>
+     *   incumbent <size> <vertices...>
+     *   frontier <count>
+     *
+     * followed by one line per subproblem, holding the size of c, its
+     * vertices, the size of p, and its vertices. */
+
+    auto read_vertices(std::istream & infile, const std::string & filename, unsigned graph_size) -> std::vector<int>
+    {
+        unsigned n;
+        if (! (infile >> n) || n > graph_size)
+            throw CheckpointFileError{ filename, "bad vertex count" };
+
+        std::vector<int> result(n);
+        for (auto & v : result)
+            if (! (infile >> v) || v < 0 || unsigned(v) >= graph_size)
+                throw CheckpointFileError{ filename, "bad vertex" };
+
+        return result;
+    }
+
+    auto expect(std::istream & infile, const std::string & filename, const std::string & word) -> void
+    {
+        std::string got;
+        if (! (infile >> got) || got != word)
+            throw CheckpointFileError{ filename, "expected '" + word + "'" };
+    }
+
+    auto write_vertices(std::ostream & outfile, const std::vector<int> & vertices) -> void
+    {
+        outfile << vertices.size();
+        for (auto & v : vertices)
+            outfile << " " << v;
+    }
+}
+
+auto read_checkpoint(const std::string & filename) -> Checkpoint
+{
+    std::ifstream infile{ filename };
+    if (! infile)
+        throw CheckpointFileError{ filename, "unable to open file" };
+
+    Checkpoint result;
+
+    expect(infile, filename, "checkpoint");
+    if (! (infile >> result.graph_size))
+        throw CheckpointFileError{ filename, "bad graph size" };
+
+    expect(infile, filename, "nodes");
+    if (! (infile >> result.nodes))
+        throw CheckpointFileError{ filename, "bad node count" };
+
+    expect(infile, filename, "incumbent");
+    result.incumbent = read_vertices(infile, filename, result.graph_size);
+
+    expect(infile, filename, "frontier");
+    unsigned n_subproblems;
+    if (! (infile >> n_subproblems))
+        throw CheckpointFileError{ filename, "bad frontier size" };
+
+    result.frontier.resize(n_subproblems);
+    for (auto & s : result.frontier) {
+        s.c = read_vertices(infile, filename, result.graph_size);
+        s.p = read_vertices(infile, filename, result.graph_size);
+    }
+
+    return result;
+}
+
+auto check_checkpoint(const std::string & filename, const Checkpoint & checkpoint, const Graph & graph) -> void
+{
+    if (checkpoint.graph_size != graph.size)
+        throw CheckpointFileError{ filename, "checkpoint is for a graph with " + std::to_string(checkpoint.graph_size) + " vertices" };
+
+    auto adjacent = [&] (unsigned a, unsigned b) -> bool {
+        if (graph.bit_rows)
+            return (graph.bit_rows[a * graph.bit_row_words + b / bits_per_word] >> (b % bits_per_word)) & 1;
+        else
+            return std::binary_search(graph.neighbours + graph.offsets[a], graph.neighbours + graph.offsets[a + 1], b);
+    };
+
+    // read_checkpoint has already checked that vertices are in range, and
+    // as there are no loops, repeated vertices aren't adjacent either
+    auto is_clique = [&] (const std::vector<int> & c) -> bool {
+        for (unsigned i = 0 ; i < c.size() ; ++i)
+            for (unsigned j = i + 1 ; j < c.size() ; ++j)
+                if (! adjacent(c[i], c[j]))
+                    return false;
+        return true;
+    };
+
+    if (! is_clique(checkpoint.incumbent))
+        throw CheckpointFileError{ filename, "incumbent is not a clique in this graph" };
+
+    for (auto & s : checkpoint.frontier)
+        if (! is_clique(s.c))
+            throw CheckpointFileError{ filename, "frontier contains something which is not a clique in this graph" };
+}
+
+auto write_checkpoint(const std::string & filename, const Checkpoint & checkpoint) -> void
+{
+    std::string temporary = filename + ".tmp";
+
+    {
+        std::ofstream outfile{ temporary };
+        if (! outfile)
+            throw CheckpointFileError{ temporary, "unable to open file for writing" };
+
+        outfile << "checkpoint " << checkpoint.graph_size << std::endl;
+        outfile << "nodes " << checkpoint.nodes << std::endl;
+        outfile << "incumbent ";
+        write_vertices(outfile, checkpoint.incumbent);
+        outfile << std::endl;
+        outfile << "frontier " << checkpoint.frontier.size() << std::endl;
+        for (auto & s : checkpoint.frontier) {
+            write_vertices(outfile, s.c);
+            outfile << " ";
+            write_vertices(outfile, s.p);
+            outfile << std::endl;
+        }
+
+        if (! outfile)
+            throw CheckpointFileError{ temporary, "error writing file" };
+    }
+
+    if (0 != std::rename(temporary.c_str(), filename.c_str()))
+        throw CheckpointFileError{ filename, "unable to rename '" + temporary + "'" };
+}
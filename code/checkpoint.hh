@@ -0,0 +1,73 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#ifndef CODE_GUARD_CHECKPOINT_HH
+#define CODE_GUARD_CHECKPOINT_HH 1
+
+#include <string>
+#include <vector>
+#include <exception>
+
+struct Graph;
+
+/**
+ * Part of the search which is still to be done: every clique which
+ * extends c using only vertices from p. Vertices are numbered as in the
+ * graph file.
+ */
+struct Subproblem
+{
+    std::vector<int> c;
+    std::vector<int> p;
+};
+
+/**
+ * Enough to carry on with an aborted search: the best clique so far, how
+ * many nodes we had processed, and everything which is left to do.
+ */
+struct Checkpoint
+{
+    /// How many vertices the graph had, as a sanity check.
+    unsigned graph_size = 0;
+
+    std::vector<int> incumbent;
+
+    unsigned long long nodes = 0;
+
+    std::vector<Subproblem> frontier;
+};
+
+/**
+ * Thrown if we can't read or write a checkpoint file, or if it is bad.
+ */
+class CheckpointFileError :
+    public std::exception
+{
+    private:
+        std::string _what;
+
+    public:
+        CheckpointFileError(const std::string & filename, const std::string & message) throw ();
+
+        auto what() const throw () -> const char *;
+};
+
+/**
+ * Read a checkpoint file.
+ */
+auto read_checkpoint(const std::string & filename) -> Checkpoint;
+
+/**
+ * Check that a checkpoint is for this graph: it must have as many
+ * vertices, and its incumbent and the c of everything in its frontier
+ * must be cliques. The graph must be adjacency lists or bit rows.
+ */
+auto check_checkpoint(const std::string & filename, const Checkpoint & checkpoint, const Graph & graph) -> void;
+
+/**
+ * Write a checkpoint file. We write to a temporary file first and then
+ * rename it, so being killed part way through leaves any old checkpoint
+ * intact.
+ */
+auto write_checkpoint(const std::string & filename, const Checkpoint & checkpoint) -> void;
+
+#endif
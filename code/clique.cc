@@ -11,6 +11,10 @@
 #include <atomic>
 #include <mutex>
 #include <chrono>
+#include <thread>
+#include <memory>
+#include <deque>
+#include <random>
 
 using std::chrono::steady_clock;
 using std::chrono::duration_cast;
@@ -18,19 +22,25 @@ using std::chrono::milliseconds;
 
 namespace
 {
+    /// The heuristic's local search gives up after this many rounds
+    /// without finding anything bigger.
+    constexpr unsigned long long heuristic_stale_rounds = 10000;
+
     struct Incumbent
     {
         const std::chrono::time_point<std::chrono::steady_clock> & start_time;
         const std::atomic<unsigned long long> & nodes;
+        const bool print;
 
         std::atomic<unsigned> value{ 0 };
 
         std::mutex mutex;
         std::vector<unsigned> c;
 
-        Incumbent(const auto & s, const auto & n) :
+        Incumbent(const auto & s, const auto & n, bool p) :
             start_time(s),
-            nodes(n)
+            nodes(n),
+            print(p)
         {
         }
 
@@ -42,11 +52,16 @@ namespace
                     unsigned new_c_size = new_c.size();
                     if (value.compare_exchange_strong(current_value, new_c_size)) {
                         std::unique_lock<std::mutex> lock(mutex);
-                        c = new_c;
-                        std::cout << "-- " << new_c.size()
-                            << " " << nodes
-                            << " " << duration_cast<milliseconds>(steady_clock::now() - start_time).count()
-                            << std::endl;
+                        // someone with something better might have got the
+                        // lock before us
+                        if (new_c.size() > c.size()) {
+                            c = new_c;
+                            if (print)
+                                std::cout << "-- " << new_c.size()
+                                    << " " << nodes
+                                    << " " << duration_cast<milliseconds>(steady_clock::now() - start_time).count()
+                                    << std::endl;
+                        }
                         break;
                     }
                 }
@@ -56,7 +71,136 @@ namespace
         }
     };
 
+    /**
+     * A branching point which a worker has made available for stealing.
+     * The owner takes branches from the top of p_order, and so do thieves,
+     * using the shared next counter. Everything else is only valid whilst
+     * live is set, and must only be read by a thief whilst holding the
+     * mutex.
+     */
+    template <unsigned n_words_, typename IndexType_>
+    struct StealPoint
+    {
+        std::mutex mutex;
+        std::atomic<bool> live{ false };
+        std::atomic<int> next{ -1 };
+
+        const unsigned * c = nullptr;
+        unsigned c_size = 0;
+        const IndexType_ * p_order = nullptr;
+        const IndexType_ * p_bounds = nullptr;
+
+        /// Vertices of p which aren't in p_order, if any.
+        const FixedBitSet<n_words_> * p_fixed = nullptr;
+    };
+
+    /**
+     * Everything we need to carry on searching from one depth of the
+     * search. Frames are kept and reused rather than living on the stack,
+     * and their p_order and p_bounds grow as needed. IndexType_ is the
+     * smallest type which can hold any vertex number or colour.
+     */
+    template <unsigned n_words_, typename IndexType_>
+    struct Frame
+    {
+        /// Vertices we might still add to c.
+        FixedBitSet<n_words_> p;
+        unsigned p_count = 0;
+
+        /// The colouring, of which the first n_branching are recorded.
+        std::vector<IndexType_> p_order, p_bounds;
+        unsigned n_branching = 0;
+
+        /// The last position in p_order we branched on.
+        int previous = 0;
+
+        /// Where we let others take branches, if we're sharing.
+        StealPoint<n_words_, IndexType_> * steal_point = nullptr;
+
+        /// Vertices of p which aren't in p_order, if we're sharing.
+        FixedBitSet<n_words_> p_fixed;
+
+        /// If we're deciding a range of omegas, the largest one whose own
+        /// search would have come here.
+        unsigned level = std::numeric_limits<unsigned>::max();
+    };
+
+    /**
+     * Part of the search, using our own vertex numbering: every clique
+     * which extends c using only vertices from p.
+     */
     template <unsigned n_words_>
+    struct Subsearch
+    {
+        std::vector<unsigned> c;
+        FixedBitSet<n_words_> p;
+    };
+
+    /**
+     * Per-thread search state.
+     */
+    template <unsigned n_words_, typename IndexType_>
+    struct Worker
+    {
+        /// Nodes we have processed but not yet added to the shared count.
+        unsigned long long nodes = 0;
+
+        /// One steal point per depth, or null if we are not sharing work.
+        std::unique_ptr<StealPoint<n_words_, IndexType_>[]> steal_points;
+
+        /// Scratch space for sorting colour classes. Colouring finishes
+        /// before we recurse, so one lot per thread is enough.
+        std::vector<unsigned> colour_class_ends, colour_class_size_counts;
+
+        /// Scratch space for deferring singleton colour classes.
+        std::vector<IndexType_> deferred;
+
+        /// Scratch space for infra-chromatic bounds and Re-NUMBER: the
+        /// first few colour classes as bitsets, which of them unit
+        /// propagation has forced, the vertices it couldn't prune, and
+        /// which vertices were renumbered. These only ever grow.
+        std::vector<FixedBitSet<n_words_> > classes;
+        std::vector<char> forced;
+        FixedBitSet<n_words_> allowed, candidates, moved;
+        std::vector<IndexType_> unproven;
+
+        /// One frame per depth. A deque, so steal points can hold on to
+        /// parts of a frame whilst we go deeper.
+        std::deque<Frame<n_words_, IndexType_> > frames;
+
+        /// How we colour, and which way we go. In a portfolio, every
+        /// worker does something different.
+        decltype(Params::how_much_sorting) how_much_sorting = Params::no_sorting;
+        bool iterate_backwards = false;
+        bool threshold_colouring = false;
+
+        /// What we didn't get round to, if we aborted.
+        std::vector<Subsearch<n_words_> > frontier;
+
+        /// If we're deciding a range of omegas, how many nodes we've
+        /// processed at each level (or higher, for Params::decide).
+        std::vector<unsigned long long> level_nodes;
+
+        /// How long we ran for.
+        std::chrono::milliseconds time{ 0 };
+
+        explicit Worker(unsigned size) :
+            colour_class_ends(size),
+            colour_class_size_counts(size + 1),
+            deferred(size),
+            unproven(size)
+        {
+        }
+
+        auto frame(unsigned depth) -> Frame<n_words_, IndexType_> &
+        {
+            while (frames.size() <= depth)
+                frames.emplace_back();
+            return frames[depth];
+        }
+    };
+
+    template <unsigned n_words_, typename IndexType_>
     struct Clique
     {
         const Params & params;
@@ -67,107 +211,198 @@ namespace
 
         std::atomic<unsigned long long> nodes;
 
+        std::list<std::chrono::milliseconds> thread_times;
+
+        std::vector<Subsearch<n_words_> > frontier;
+
+        /// Set when a portfolio worker finishes, so the others can stop.
+        std::atomic<bool> portfolio_done{ false };
+
+        /// If we're deciding a range of omegas, how many nodes each one
+        /// which has been answered took.
+        std::vector<unsigned long long> decision_nodes;
+
         Clique(const Graph & g, const Params & q) :
             params(q),
             order(g.size),
             invorder(g.size),
-            incumbent(params.start_time, nodes),
+            incumbent(params.start_time, nodes, params.print_incumbents),
             nodes(0)
         {
             // populate our order with every vertex initially
             std::iota(order.begin(), order.end(), 0);
 
+            // if we're given bit rows, collect them in the original order
+            // first
+            bool use_unordered = g.bit_rows;
+            FixedBitGraph<n_words_> unordered;
+            if (g.bit_rows) {
+                unordered.resize(g.size);
+                for (unsigned i = 0 ; i < g.size ; ++i)
+                    unordered.assign_row_words(i, g.bit_rows + i * g.bit_row_words, g.bit_row_words);
+            }
+
             // pre-calculate degrees
             std::vector<int> degrees;
             degrees.resize(g.size);
             for (unsigned i = 0 ; i < g.size ; ++i)
-                degrees[i] = g.edges[i].size();
+                degrees[i] = use_unordered ? unordered.degree(i) : g.degree(i);
+
+            auto for_each_neighbour = [&] (unsigned v, const auto & f) {
+                if (use_unordered)
+                    unordered.neighbourhood(v).for_each_set_bit(f);
+                else
+                    for (auto n = g.offsets[v] ; n < g.offsets[v + 1] ; ++n)
+                        f(g.neighbours[n]);
+            };
 
-            // sort on degree
+            // sort on degree, which the other orderings start from too
             std::sort(order.begin(), order.end(),
                     [&] (int a, int b) { return true ^ (degrees[a] < degrees[b] || (degrees[a] == degrees[b] && a > b)); });
 
+            switch (params.initial_ordering) {
+                case Params::degree_order:
+                    break;
+
+                case Params::degeneracy_order:
+                    {
+                        // whatever is removed last goes first
+                        std::vector<unsigned> core(degrees.begin(), degrees.end()), ordering;
+                        core_decomposition(core, ordering, for_each_neighbour);
+                        std::copy(ordering.rbegin(), ordering.rend(), order.begin());
+                    }
+                    break;
+
+                case Params::ex_degree_order:
+                    {
+                        // break degree ties on the sum of neighbours' degrees
+                        std::vector<long long> ex_degrees(g.size, 0);
+                        for (unsigned i = 0 ; i < g.size ; ++i)
+                            for_each_neighbour(i, [&] (unsigned e) { ex_degrees[i] += degrees[e]; });
+                        std::stable_sort(order.begin(), order.end(), [&] (int a, int b) {
+                                return degrees[a] > degrees[b] || (degrees[a] == degrees[b] && ex_degrees[a] > ex_degrees[b]);
+                                });
+                    }
+                    break;
+
+                case Params::colour_order:
+                    {
+                        // greedily colour in degree order, then keep each
+                        // colour class together, smallest colour first
+                        std::vector<unsigned> colours(g.size, 0), used_by(g.size + 1, g.size);
+                        for (auto & v : order) {
+                            for_each_neighbour(v, [&] (unsigned e) {
+                                    if (0 != colours[e])
+                                        used_by[colours[e]] = v;
+                                    });
+                            unsigned colour = 1;
+                            while (used_by[colour] == unsigned(v))
+                                ++colour;
+                            colours[v] = colour;
+                        }
+                        std::stable_sort(order.begin(), order.end(), [&] (int a, int b) { return colours[a] < colours[b]; });
+                    }
+                    break;
+            }
+
             // re-encode graph as a bit graph
             graph.resize(g.size);
 
             for (unsigned i = 0 ; i < order.size() ; ++i)
                 invorder[order[i]] = i;
 
-            for (unsigned i = 0 ; i < order.size() ; ++i)
-                for (auto & e : g.edges[i])
-                    graph.add_edge(invorder[i], invorder[e]);
+            if (use_unordered) {
+                for (unsigned i = 0 ; i < order.size() ; ++i)
+                    unordered.neighbourhood(i).for_each_set_bit([&] (int e) {
+                            if (unsigned(e) > i)
+                                graph.add_edge(invorder[i], invorder[e]);
+                            });
+            }
+            else
+                for (unsigned i = 0 ; i < order.size() ; ++i)
+                    for (auto n = g.offsets[i] ; n < g.offsets[i + 1] ; ++n)
+                        if (g.neighbours[n] > i)
+                            graph.add_edge(invorder[i], invorder[g.neighbours[n]]);
         }
 
+        /**
+         * Greedy colouring. Anything given a colour of k or less can never
+         * be branched on, because the bound will fail first, so we only
+         * record vertices with larger colours. Returns how many vertices
+         * were recorded.
+         */
         auto colour_class_order(
                 const FixedBitSet<n_words_> & p,
-                std::array<unsigned, n_words_ * bits_per_word> & p_order,
-                std::array<unsigned, n_words_ * bits_per_word> & p_bounds) -> void
+                unsigned p_count,
+                unsigned k,
+                IndexType_ * p_order,
+                IndexType_ * p_bounds) -> unsigned
         {
             FixedBitSet<n_words_> p_left = p; // not coloured yet
+            FixedBitSet<n_words_> q;          // can have the current colour
             unsigned colour = 0;         // current colour
+            unsigned coloured = 0;       // how many things we've coloured
             unsigned i = 0;              // position in p_bounds
 
             // while we've things left to colour
-            while (! p_left.empty()) {
+            while (coloured < p_count) {
                 // next colour
                 ++colour;
                 // things that can still be given this colour
-                FixedBitSet<n_words_> q = p_left;
-
-                // while we can still give something this colour
-                while (! q.empty()) {
-                    // first thing we can colour
-                    int v = q.first_set_bit();
-                    p_left.unset(v);
-                    q.unset(v);
-
-                    // can't give anything adjacent to this the same colour
-                    graph.intersect_with_row_complement(v, q);
-
-                    // record in result
-                    p_bounds[i] = colour;
-                    p_order[i] = v;
-                    ++i;
-                }
+                q = p_left;
+
+                // give this colour to as much as we can, in order, noting
+                // that nothing adjacent can have the same colour
+                graph.take_independent_set(q, [&] (int v) {
+                        p_left.unset(v);
+                        ++coloured;
+
+                        // record in result, if we might branch on it
+                        if (colour > k) {
+                            p_bounds[i] = colour;
+                            p_order[i] = v;
+                            ++i;
+                        }
+                        });
             }
+
+            return i;
         }
 
         auto colour_class_order_defer1(
+                Worker<n_words_, IndexType_> & worker,
                 const FixedBitSet<n_words_> & p,
-                std::array<unsigned, n_words_ * bits_per_word> & p_order,
-                std::array<unsigned, n_words_ * bits_per_word> & p_bounds) -> void
+                unsigned p_count,
+                IndexType_ * p_order,
+                IndexType_ * p_bounds) -> void
         {
             FixedBitSet<n_words_> p_left = p; // not coloured yet
+            FixedBitSet<n_words_> q;          // can have the current colour
             unsigned colour = 0;        // current colour
             unsigned i = 0;             // position in p_bounds
 
             unsigned d = 0;             // number deferred
-            std::array<unsigned, n_words_ * bits_per_word> defer;
+            auto & defer = worker.deferred;
 
             // while we've things left to colour
-            while (! p_left.empty()) {
+            while (i + d < p_count) {
                 // next colour
                 ++colour;
                 // things that can still be given this colour
-                FixedBitSet<n_words_> q = p_left;
+                q = p_left;
 
-                // while we can still give something this colour
+                // give this colour to as much as we can, in order, noting
+                // that nothing adjacent can have the same colour
                 unsigned number_with_this_colour = 0;
-                while (! q.empty()) {
-                    // first thing we can colour
-                    int v = q.first_set_bit();
-                    p_left.unset(v);
-                    q.unset(v);
-
-                    // can't give anything adjacent to this the same colour
-                    graph.intersect_with_row_complement(v, q);
-
-                    // record in result
-                    p_bounds[i] = colour;
-                    p_order[i] = v;
-                    ++i;
-                    ++number_with_this_colour;
-                }
+                graph.take_independent_set(q, [&] (int v) {
+                        p_left.unset(v);
+
+                        // record in result
+                        p_bounds[i] = colour;
+                        p_order[i] = v;
+                        ++i;
+                        ++number_with_this_colour;
+                        });
 
                 if (1 == number_with_this_colour) {
                     --i;
@@ -184,93 +419,433 @@ namespace
             }
         }
 
+        /**
+         * Greedy colouring, then stably sort the colour classes by size,
+         * largest first. Classes are written straight into p_order with
+         * their end offsets in the worker's scratch space, and sorted by
+         * counting, so nothing is allocated.
+         */
         auto colour_class_order_sort(
+                Worker<n_words_, IndexType_> & worker,
                 const FixedBitSet<n_words_> & p,
-                std::array<unsigned, n_words_ * bits_per_word> & p_order,
-                std::array<unsigned, n_words_ * bits_per_word> & p_bounds) -> void
+                unsigned p_count,
+                IndexType_ * p_order,
+                IndexType_ * p_bounds) -> void
         {
             FixedBitSet<n_words_> p_left = p; // not coloured yet
-            std::vector<std::vector<unsigned> > colour_classes;
+            FixedBitSet<n_words_> q;          // can have the current colour
+            auto & ends = worker.colour_class_ends;
+            auto & size_counts = worker.colour_class_size_counts;
+            unsigned n_classes = 0;
+            unsigned largest = 0;
+            unsigned i = 0;              // position in p_order
 
             // while we've things left to colour
-            while (! p_left.empty()) {
-                // next colour
-                colour_classes.push_back({});
-
+            while (i < p_count) {
                 // things that can still be given this colour
-                FixedBitSet<n_words_> q = p_left;
+                q = p_left;
+
+                // give this colour to as much as we can, in order, noting
+                // that nothing adjacent can have the same colour
+                unsigned start = i;
+                graph.take_independent_set(q, [&] (int v) {
+                        p_left.unset(v);
+
+                        // record in result, for now in colour order
+                        p_order[i] = v;
+                        ++i;
+                        });
+
+                ends[n_classes++] = i;
+                ++size_counts[i - start];
+                largest = std::max(largest, i - start);
+            }
+
+            // turn size counts into where the first class of each size goes,
+            // biggest first, and then give each colour class its place,
+            // using p_bounds as somewhere to put vertices for now
+            unsigned position = 0;
+            for (unsigned size = largest ; size >= 1 ; --size) {
+                unsigned n_this_size = size_counts[size];
+                size_counts[size] = position;
+                position += n_this_size * size;
+            }
 
-                // while we can still give something this colour
-                while (! q.empty()) {
-                    // first thing we can colour
-                    int v = q.first_set_bit();
-                    p_left.unset(v);
-                    q.unset(v);
+            for (unsigned c = 0, start = 0 ; c < n_classes ; start = ends[c++]) {
+                unsigned & target = size_counts[ends[c] - start];
+                std::copy(p_order + start, p_order + ends[c], p_bounds + target);
+                target += ends[c] - start;
+            }
 
-                    // can't give anything adjacent to this the same colour
-                    graph.intersect_with_row_complement(v, q);
+            std::copy(p_bounds, p_bounds + p_count, p_order);
 
-                    // record in result
-                    colour_classes.back().push_back(v);
+            // colours go up as class sizes go down, and each size's slot
+            // now says where its classes end
+            unsigned colour = 0;
+            position = 0;
+            for (unsigned size = largest ; size >= 1 ; --size) {
+                for ( ; position < size_counts[size] ; position += size) {
+                    ++colour;
+                    std::fill(p_bounds + position, p_bounds + position + size, colour);
                 }
+                size_counts[size] = 0;
             }
+        }
+
+        /**
+         * Greedy colouring, followed by MCS-style Re-NUMBER: if we need k
+         * more vertices to beat the incumbent, anything given a colour
+         * above k is a branching vertex. For each of these, try to move it
+         * into one of the first k classes, either directly if it has no
+         * neighbours there, or by moving its only neighbour w from that
+         * class into a later one of the first k classes which contains no
+         * neighbours of w. Classes which end up empty are dropped.
+         */
+        auto colour_class_order_renumber(
+                Worker<n_words_, IndexType_> & worker,
+                const FixedBitSet<n_words_> & p,
+                unsigned p_count,
+                unsigned c_size,
+                IndexType_ * p_order,
+                IndexType_ * p_bounds) -> void
+        {
+            colour_class_order(p, p_count, 0, p_order, p_bounds);
 
-            std::stable_sort(colour_classes.begin(), colour_classes.end(), [] (const auto & a, const auto & b) {
-                    return a.size() > b.size();
-                    });
+            // nothing is branching, or there's nowhere to move things to?
+            unsigned value = incumbent.value;
+            unsigned k = value > c_size ? value - c_size : 0;
+            if (0 == p_count || p_bounds[p_count - 1] <= k || 0 == k)
+                return;
 
-            unsigned colour = 0;         // current colour
-            unsigned i = 0;              // position in p_bounds
+            unsigned start = std::lower_bound(p_bounds, p_bounds + p_count, k + 1) - p_bounds;
 
-            for (auto & c : colour_classes) {
-                ++colour;
-                for (auto & v : c) {
-                    p_order[i] = v;
-                    p_bounds[i] = colour;
-                    ++i;
+            auto & classes = worker.classes;
+            if (classes.size() < k) {
+                classes.resize(k);
+                worker.forced.resize(k);
+            }
+            for (unsigned k1 = 0 ; k1 < k ; ++k1)
+                classes[k1].unset_all();
+            for (unsigned n = 0 ; n < start ; ++n)
+                classes[p_bounds[n] - 1].set(p_order[n]);
+
+            auto & moved = worker.moved;
+            auto & scratch = worker.candidates;
+            moved.unset_all();
+            unsigned n_moved = 0;
+            for (unsigned n = start ; n < p_count ; ++n) {
+                auto v = p_order[n];
+                for (unsigned k1 = 0 ; k1 < k ; ++k1) {
+                    unsigned v_neighbours = graph.intersect_row_into(v, classes[k1], scratch);
+                    if (v_neighbours > 1)
+                        continue;
+
+                    if (1 == v_neighbours) {
+                        // can we move v's one neighbour to a later class? It
+                        // was coloured greedily, so it won't fit earlier.
+                        int w = scratch.first_set_bit();
+                        unsigned k2 = k1 + 1;
+                        while (k2 < k && 0 != graph.intersect_row_into(w, classes[k2], scratch))
+                            ++k2;
+                        if (k2 == k)
+                            continue;
+
+                        classes[k1].unset(w);
+                        classes[k2].set(w);
+                    }
+
+                    classes[k1].set(v);
+                    moved.set(v);
+                    ++n_moved;
+                    break;
                 }
             }
+
+            if (0 == n_moved)
+                return;
+
+            // shuffle what's left of the branching vertices to the end,
+            // keeping them in order
+            unsigned write = p_count;
+            for (unsigned read = p_count ; read > start ; --read) {
+                if (moved.test(p_order[read - 1]))
+                    continue;
+                --write;
+                p_order[write] = p_order[read - 1];
+                p_bounds[write] = p_bounds[read - 1];
+            }
+
+            // renumber what's left, in case some classes are now empty
+            unsigned colour = k;
+            unsigned previous_bound = 0;
+            for (unsigned n = write ; n < p_count ; ++n) {
+                if (p_bounds[n] != previous_bound)
+                    ++colour;
+                previous_bound = p_bounds[n];
+                p_bounds[n] = colour;
+            }
+
+            // and the first k classes go in front of them
+            unsigned i = 0;
+            for (unsigned k1 = 0 ; k1 < k ; ++k1)
+                classes[k1].for_each_set_bit([&] (int v) {
+                        p_order[i] = v;
+                        p_bounds[i] = k1 + 1;
+                        ++i;
+                        });
         }
 
-        auto expand(
-                std::vector<unsigned> & c,
-                FixedBitSet<n_words_> & p
+        /**
+         * Could v be in a clique which uses one vertex from each of the
+         * supplied colour classes? Any such clique must contain a neighbour
+         * of v from every class, so we unit propagate, MaxSAT style: a
+         * class with only one candidate left forces that vertex in, which
+         * removes its non-neighbours from every other class, and a class
+         * with no candidates left means there can be no such clique.
+         */
+        auto fails_unit_propagation(Worker<n_words_, IndexType_> & worker, unsigned v, unsigned k) -> bool
+        {
+            auto & allowed = worker.allowed;
+            auto & candidates = worker.candidates;
+            allowed = graph.neighbourhood(v);
+            std::fill(worker.forced.begin(), worker.forced.begin() + k, false);
+
+            for (bool changed = true ; changed ; ) {
+                changed = false;
+                for (unsigned j = 0 ; j < k ; ++j) {
+                    if (worker.forced[j])
+                        continue;
+
+                    switch (candidates.assign_intersection(worker.classes[j], allowed)) {
+                        case 0:
+                            return true;
+
+                        case 1:
+                            worker.forced[j] = true;
+                            graph.intersect_with_row(candidates.first_set_bit(), allowed);
+                            changed = true;
+                            break;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * Infra-chromatic bound strengthening. If we need k more vertices
+         * to beat the incumbent, anything given colour k + 1 is a branching
+         * vertex, but it can be pruned if it can't form a (k + 1)-clique
+         * with colour classes 1 to k. We move vertices where unit
+         * propagation shows this to the front of their class, and lower
+         * their bound to k. The class is independent, so a clique still
+         * only uses one vertex from it, and the bounds remain valid even
+         * if the incumbent later changes.
+         */
+        auto strengthen_bounds(
+                Worker<n_words_, IndexType_> & worker,
+                unsigned c_size,
+                unsigned p_count,
+                IndexType_ * p_order,
+                IndexType_ * p_bounds) -> void
+        {
+            unsigned value = incumbent.value;
+            if (value <= c_size)
+                return;
+            unsigned k = value - c_size;
+
+            // colour classes are contiguous, and bounds are non-decreasing
+            unsigned start = std::lower_bound(p_bounds, p_bounds + p_count, k + 1) - p_bounds;
+            unsigned end = std::upper_bound(p_bounds + start, p_bounds + p_count, k + 1) - p_bounds;
+            if (start == end)
+                return;
+
+            if (worker.classes.size() < k) {
+                worker.classes.resize(k);
+                worker.forced.resize(k);
+            }
+            for (unsigned j = 0 ; j < k ; ++j)
+                worker.classes[j].unset_all();
+            for (unsigned i = 0 ; i < start ; ++i)
+                worker.classes[p_bounds[i] - 1].set(p_order[i]);
+
+            // proven vertices go first, keeping both lots in order
+            unsigned write = start, n_unproven = 0;
+            for (unsigned i = start ; i < end ; ++i) {
+                if (fails_unit_propagation(worker, p_order[i], k))
+                    p_order[write++] = p_order[i];
+                else
+                    worker.unproven[n_unproven++] = p_order[i];
+            }
+            std::copy(worker.unproven.begin(), worker.unproven.begin() + n_unproven, p_order + write);
+            std::fill(p_bounds + start, p_bounds + write, k);
+        }
+
+        /**
+         * Find a clique quickly, to start off with. First grow one greedily
+         * from each vertex in turn, always adding the earliest candidate.
+         * Then try to improve the best of these with a simple local search:
+         * kick out a random vertex, grow again picking candidates at random,
+         * and go back to the best if we got worse. Stops when time runs
+         * out, when the local search stops improving, when we've met the
+         * colour bound for the whole graph, or when we're deciding and
+         * have found a big enough clique.
+         */
+        auto heuristic() -> void
+        {
+            std::vector<unsigned> best, c;
+            FixedBitSet<n_words_> p;
+
+            // nothing can beat the number of colours we need for everything
+            p.set_up_to(graph.size());
+            std::vector<IndexType_> p_order(graph.size()), p_bounds(graph.size());
+            colour_class_order(p, graph.size(), 0, p_order.data(), p_bounds.data());
+            unsigned bound = 0 == graph.size() ? 0 : p_bounds.back();
+
+            auto stop_time = steady_clock::now() + params.heuristic_time;
+            auto out_of_time = [&] {
+                return params.abort->load() || steady_clock::now() >= stop_time || best.size() >= bound
+                    || (params.decide > 0 && best.size() >= params.decide);
+            };
+
+            for (int s = 0 ; s < graph.size() && ! out_of_time() ; ++s) {
+                if (unsigned(graph.degree(s)) + 1 <= best.size())
+                    continue;
+
+                c.assign(1, s);
+                p = graph.neighbourhood(s);
+                for (int v ; -1 != (v = p.first_set_bit()) ; ) {
+                    c.push_back(v);
+                    graph.intersect_with_row(v, p);
+                }
+
+                if (c.size() > best.size())
+                    best = c;
+            }
+
+            std::mt19937 rand;
+            c = best;
+            unsigned long long stale = 0;
+            while (! c.empty() && stale < heuristic_stale_rounds && ! out_of_time()) {
+                std::swap(c[rand() % c.size()], c.back());
+                unsigned kicked = c.back();
+                c.pop_back();
+
+                p.set_up_to(graph.size());
+                for (auto & v : c)
+                    graph.intersect_with_row(v, p);
+                p.unset(kicked);
+
+                for (unsigned p_count ; 0 != (p_count = p.popcount()) ; ) {
+                    unsigned skip = rand() % p_count;
+                    int v = -1;
+                    p.for_each_set_bit([&] (int w) {
+                            if (0 == skip--)
+                                v = w;
+                            });
+                    c.push_back(v);
+                    graph.intersect_with_row(v, p);
+                }
+
+                if (c.size() > best.size()) {
+                    best = c;
+                    stale = 0;
+                }
+                else {
+                    ++stale;
+                    if (c.size() < best.size())
+                        c = best;
+                }
+            }
+
+            incumbent.update(best);
+        }
+
+        /**
+         * Tell a worker how to colour and which way to go.
+         */
+        auto configure(Worker<n_words_, IndexType_> & worker, decltype(Params::how_much_sorting) how_much_sorting, bool iterate_backwards) -> void
+        {
+            worker.how_much_sorting = how_much_sorting;
+            worker.iterate_backwards = iterate_backwards;
+
+            // backwards iteration, tau and infra-chromatic bounds all need to
+            // see every colour class
+            worker.threshold_colouring = params.threshold_colouring && ! iterate_backwards
+                && ! params.measure_kendall_tau && ! params.infra_chromatic;
+        }
+
+        auto flush_nodes(Worker<n_words_, IndexType_> & worker) -> void
+        {
+            nodes += worker.nodes;
+            worker.nodes = 0;
+        }
+
+        /**
+         * Start a new search node, whose p and p_count have already been
+         * filled in: colour p, and get ready to branch.
+         */
+        auto enter(
+                Worker<n_words_, IndexType_> & worker,
+                const std::vector<unsigned> & c,
+                Frame<n_words_, IndexType_> & frame
                 ) -> void
         {
-            ++nodes;
+            ++worker.nodes;
+            if (0 != params.decide_from)
+                ++worker.level_nodes[std::min(frame.level, params.decide)];
+
+            const auto & p = frame.p;
+            unsigned p_count = frame.p_count;
 
             // initial colouring
-            std::array<unsigned, n_words_ * bits_per_word> p_order;
-            std::array<unsigned, n_words_ * bits_per_word> p_bounds;
+            if (frame.p_order.size() < p_count) {
+                frame.p_order.resize(p_count);
+                frame.p_bounds.resize(p_count);
+            }
+            IndexType_ * p_order = frame.p_order.data();
+            IndexType_ * p_bounds = frame.p_bounds.data();
+
+            // if we're only recording branching vertices, how many are there?
+            unsigned n_branching = p_count;
 
-            switch (params.how_much_sorting) {
+            switch (worker.how_much_sorting) {
                 case Params::no_sorting:
-                    colour_class_order(p, p_order, p_bounds);
+                    if (worker.threshold_colouring) {
+                        unsigned value = incumbent.value;
+                        n_branching = colour_class_order(p, p_count, value > c.size() ? value - c.size() : 0, p_order, p_bounds);
+                    }
+                    else
+                        colour_class_order(p, p_count, 0, p_order, p_bounds);
                     break;
 
                 case Params::defer1:
-                    colour_class_order_defer1(p, p_order, p_bounds);
+                    colour_class_order_defer1(worker, p, p_count, p_order, p_bounds);
                     break;
 
                 case Params::full_sort:
-                    colour_class_order_sort(p, p_order, p_bounds);
+                    colour_class_order_sort(worker, p, p_count, p_order, p_bounds);
+                    break;
+
+                case Params::renumber:
+                    colour_class_order_renumber(worker, p, p_count, c.size(), p_order, p_bounds);
                     break;
             }
 
-            if (params.iterate_backwards) {
-                auto n_colours = p_bounds[p.popcount() - 1];
+            if (worker.iterate_backwards) {
+                auto n_colours = p_bounds[p_count - 1];
 
-                std::reverse(p_order.begin(), p_order.begin() + p.popcount());
-                std::reverse(p_bounds.begin(), p_bounds.begin() + p.popcount());
+                std::reverse(p_order, p_order + p_count);
+                std::reverse(p_bounds, p_bounds + p_count);
 
-                for (unsigned i = 0 ; i < p.popcount() ; ++i)
+                for (unsigned i = 0 ; i < p_count ; ++i)
                     p_bounds[i] = n_colours - p_bounds[i] + 1;
             }
 
             if (params.measure_kendall_tau) {
                 std::vector<unsigned> sizes;
                 unsigned count = 0;
-                for (unsigned i = 0 ; i < p.popcount() ; ++i) {
+                for (unsigned i = 0 ; i < p_count ; ++i) {
                     ++count;
                     if (i > 0 && p_bounds[i - 1] != p_bounds[i]) {
                         sizes.push_back(count);
@@ -293,7 +868,7 @@ namespace
 
                 sort(sizes.begin(), sizes.end(), [] (auto a, auto b) { return a > b; });
 
-                unsigned rank = p.popcount();
+                unsigned rank = p_count;
                 for (unsigned i = 0 ; i < sizes.size() ; ++i) {
                     if (i > 0 && sizes[i - 1] != sizes[i])
                         --rank;
@@ -302,66 +877,454 @@ namespace
                     std::cerr << rank;
                 }
 
-                std::cerr << "); invisible(cat(paste(" << p_bounds[p.popcount() - 1] << ", cor(a, b, method=\"kendall\"), \"\\n\")));" << std::endl;
+                std::cerr << "); invisible(cat(paste(" << p_bounds[p_count - 1] << ", cor(a, b, method=\"kendall\"), \"\\n\")));" << std::endl;
             }
 
-            // for each v in p... (v comes later)
-            for (int n = p.popcount() - 1 ; n >= 0 ; --n) {
-                // bound, timeout or early exit?
-                if (c.size() + p_bounds[n] <= incumbent.value || (params.decide > 0 && incumbent.value >= params.decide) || params.abort->load())
-                    return;
+            if (params.infra_chromatic)
+                strengthen_bounds(worker, c.size(), p_count, p_order, p_bounds);
+
+            // let other workers take branches from here, if we're sharing
+            frame.n_branching = n_branching;
+            frame.previous = n_branching;
+            frame.steal_point = nullptr;
+            if (worker.steal_points) {
+                // thieves need to know about things we didn't record
+                if (n_branching != p_count) {
+                    frame.p_fixed = p;
+                    for (unsigned n = 0 ; n < n_branching ; ++n)
+                        frame.p_fixed.unset(p_order[n]);
+                }
 
-                auto v = p_order[n];
+                auto steal_point = frame.steal_point = &worker.steal_points[c.size()];
+                std::unique_lock<std::mutex> guard(steal_point->mutex);
+                steal_point->c = c.data();
+                steal_point->c_size = c.size();
+                steal_point->p_order = p_order;
+                steal_point->p_bounds = p_bounds;
+                steal_point->p_fixed = n_branching != p_count ? &frame.p_fixed : nullptr;
+                steal_point->next = int(n_branching) - 1;
+                steal_point->live = true;
+            }
+        }
+
+        /**
+         * Find the next position in p_order to branch on from this frame,
+         * or -1 if we're done with it.
+         */
+        auto next_branch(
+                const std::vector<unsigned> & c,
+                Frame<n_words_, IndexType_> & frame
+                ) -> int
+        {
+            auto steal_point = frame.steal_point;
+            int n = steal_point ? steal_point->next.fetch_sub(1) : frame.previous - 1;
+            if (n < 0)
+                return -1;
+
+            // anything we skipped over was stolen, so it's not ours
+            for (int x = frame.previous - 1 ; x > n ; --x)
+                frame.p.unset(frame.p_order[x]);
+            frame.previous = n;
+
+            // bound, timeout or early exit?
+            if (c.size() + frame.p_bounds[n] <= incumbent.value || frame.level <= incumbent.value
+                    || (params.decide > 0 && incumbent.value >= params.decide) || params.abort->load()
+                    || (params.portfolio && portfolio_done.load()))
+                return -1;
+
+            return n;
+        }
+
+        /**
+         * We're deciding a range of omegas, and have found a maximal clique
+         * c, which the search for every omega up to level would also have
+         * found. Those which haven't been answered yet now have been, in
+         * as many nodes as we've processed at their level or above. The
+         * incumbent is always one less than the smallest omega we're still
+         * deciding, so everything their searches would do, we do too.
+         */
+        auto decided(Worker<n_words_, IndexType_> & worker, const std::vector<unsigned> & c, unsigned level) -> void
+        {
+            unsigned value = incumbent.value, to = std::min({ level, unsigned(c.size()), params.decide });
+            if (to <= value)
+                return;
+
+            unsigned long long n = 0;
+            for (unsigned omega = params.decide ; omega > value ; --omega) {
+                n += worker.level_nodes[omega];
+                if (omega <= to)
+                    decision_nodes[omega] = n;
+            }
+
+            if (c.size() > incumbent.c.size())
+                incumbent.c = c;
+            incumbent.value = to;
+        }
+
+        /**
+         * We're done with a frame, so nobody else can have its branches.
+         */
+        auto leave(Frame<n_words_, IndexType_> & frame) -> void
+        {
+            if (frame.steal_point) {
+                std::unique_lock<std::mutex> guard(frame.steal_point->mutex);
+                frame.steal_point->live = false;
+            }
+        }
+
+        /**
+         * We're aborting, so for every frame from the current depth back up
+         * to base_depth, deepest first, note what's left to do and stop
+         * anyone else from taking it.
+         */
+        auto record_frontier(
+                Worker<n_words_, IndexType_> & worker,
+                std::vector<unsigned> & c,
+                unsigned base_depth
+                ) -> void
+        {
+            for (unsigned depth = c.size() + 1 ; depth-- > base_depth ; ) {
+                auto & frame = worker.frame(depth);
+                Subsearch<n_words_> left{ { c.begin(), c.begin() + depth }, frame.p };
+
+                // anything between next and previous was stolen, and the
+                // thief will record it
+                int next = frame.steal_point ? frame.steal_point->next.exchange(-1) : frame.previous - 1;
+                for (int x = frame.previous - 1 ; x > next ; --x)
+                    left.p.unset(frame.p_order[x]);
+                leave(frame);
+
+                // the branch we're part way through is below us
+                if (depth < c.size())
+                    left.p.unset(c[depth]);
+
+                if (depth + left.p.popcount() > incumbent.value)
+                    worker.frontier.push_back(std::move(left));
+            }
+
+            c.resize(base_depth);
+        }
+
+        /**
+         * Search everything below c and p. We keep our own stack of frames,
+         * one per depth, rather than recursing, so c.size() always says
+         * which frame we're working on.
+         */
+        auto expand(
+                Worker<n_words_, IndexType_> & worker,
+                std::vector<unsigned> & c,
+                const FixedBitSet<n_words_> & p,
+                unsigned p_count
+                ) -> void
+        {
+            unsigned base_depth = c.size();
+            auto & base = worker.frame(base_depth);
+            base.p = p;
+            base.p_count = p_count;
+            base.level = std::numeric_limits<unsigned>::max();
+            enter(worker, c, base);
+
+            while (true) {
+                if (params.record_frontier && params.abort->load()) {
+                    record_frontier(worker, c, base_depth);
+                    break;
+                }
+
+                auto & frame = worker.frame(c.size());
+
+                // for each v in p... (v comes later)
+                int n = next_branch(c, frame);
+                if (n < 0) {
+                    leave(frame);
+                    if (c.size() == base_depth)
+                        break;
+
+                    // back up, and now consider not taking v
+                    auto v = c.back();
+                    c.pop_back();
+                    worker.frame(c.size()).p.unset(v);
+                    continue;
+                }
+
+                auto v = frame.p_order[n];
 
                 // consider taking v
                 c.push_back(v);
 
                 // filter p to contain vertices adjacent to v
-                FixedBitSet<n_words_> new_p = p;
-                graph.intersect_with_row(v, new_p);
+                auto & child = worker.frame(c.size());
+                child.p_count = graph.intersect_row_into(v, frame.p, child.p);
+                if (0 != params.decide_from)
+                    child.level = std::min<unsigned>(frame.level, c.size() - 1 + frame.p_bounds[n]);
+
+                if (0 != child.p_count)
+                    enter(worker, c, child);
+                else {
+                    flush_nodes(worker);
+                    if (0 != params.decide_from)
+                        decided(worker, c, child.level);
+                    else
+                        incumbent.update(c);
+
+                    // now consider not taking v
+                    c.pop_back();
+                    frame.p.unset(v);
+                }
+            }
+        }
 
-                if (! new_p.empty())
-                    expand(c, new_p);
+        /**
+         * Try to take a branch from another worker, preferring the
+         * shallowest available. Returns false if there was nothing to
+         * take. On success, busy has already been incremented.
+         */
+        auto steal(std::vector<Worker<n_words_, IndexType_> > & workers, std::atomic<unsigned> & busy,
+                std::vector<unsigned> & c, FixedBitSet<n_words_> & p) -> bool
+        {
+            for (int depth = 0 ; depth <= graph.size() ; ++depth) {
+                for (auto & victim : workers) {
+                    auto & steal_point = victim.steal_points[depth];
+                    if (! steal_point.live.load() || steal_point.next.load() < 0)
+                        continue;
+
+                    std::unique_lock<std::mutex> guard(steal_point.mutex);
+                    if (! steal_point.live.load())
+                        continue;
+
+                    int n = steal_point.next.fetch_sub(1);
+                    if (n < 0)
+                        continue;
+
+                    // if this branch can't win, neither can anything after it
+                    if (steal_point.c_size + steal_point.p_bounds[n] <= incumbent.value) {
+                        steal_point.next = -1;
+                        continue;
+                    }
+
+                    // branch n considers vertices up to and including n
+                    auto v = steal_point.p_order[n];
+                    c.assign(steal_point.c, steal_point.c + steal_point.c_size);
+                    c.push_back(v);
+                    if (steal_point.p_fixed)
+                        p = *steal_point.p_fixed;
+                    else
+                        p.unset_all();
+                    for (int x = 0 ; x <= n ; ++x)
+                        p.set(steal_point.p_order[x]);
+                    graph.intersect_with_row(v, p);
+
+                    ++busy;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        auto run_worker(std::vector<Worker<n_words_, IndexType_> > & workers, Worker<n_words_, IndexType_> & worker, std::atomic<unsigned> & busy) -> void
+        {
+            std::vector<unsigned> c;
+            c.reserve(graph.size());
+            FixedBitSet<n_words_> p;
+
+            while (! params.abort->load()) {
+                if (steal(workers, busy, c, p)) {
+                    unsigned p_count = p.popcount();
+                    if (0 != p_count)
+                        expand(worker, c, p, p_count);
+                    else {
+                        flush_nodes(worker);
+                        incumbent.update(c);
+                    }
+                    --busy;
+                }
+                else if (0 == busy.load())
+                    break;
                 else
-                    incumbent.update(c);
+                    std::this_thread::yield();
+            }
 
-                // now consider not taking v
-                c.pop_back();
-                p.unset(v);
+            flush_nodes(worker);
+            worker.time = duration_cast<milliseconds>(steady_clock::now() - params.start_time);
+        }
+
+        /**
+         * Search one of the places we were asked to start from, or if
+         * we've already been told to abort, remember that we didn't.
+         */
+        auto search_from(Worker<n_words_, IndexType_> & worker, std::vector<unsigned> & c, const Subsearch<n_words_> & start) -> void
+        {
+            if (params.abort->load()) {
+                if (params.record_frontier)
+                    worker.frontier.push_back(start);
+                return;
+            }
+
+            c.assign(start.c.begin(), start.c.end());
+            unsigned p_count = start.p.popcount();
+            if (0 != p_count)
+                expand(worker, c, start.p, p_count);
+            else {
+                flush_nodes(worker);
+                incumbent.update(c);
+            }
+        }
+
+        auto run_parallel(std::vector<unsigned> & c, const std::vector<Subsearch<n_words_> > & starts) -> void
+        {
+            std::vector<Worker<n_words_, IndexType_> > workers;
+            for (unsigned t = 0 ; t < params.n_threads ; ++t)
+                workers.emplace_back(graph.size());
+            for (auto & w : workers) {
+                configure(w, params.how_much_sorting, params.iterate_backwards);
+                w.steal_points.reset(new StealPoint<n_words_, IndexType_>[graph.size() + 1]);
+            }
+
+            // the first worker starts at the top, and everyone else steals
+            std::atomic<unsigned> busy{ 1 };
+            std::vector<std::thread> threads;
+            for (unsigned t = 1 ; t < params.n_threads ; ++t)
+                threads.emplace_back([&, t] { run_worker(workers, workers[t], busy); });
+
+            for (auto & start : starts)
+                search_from(workers[0], c, start);
+            --busy;
+            run_worker(workers, workers[0], busy);
+
+            for (auto & t : threads)
+                t.join();
+
+            for (auto & w : workers) {
+                thread_times.push_back(w.time);
+                frontier.insert(frontier.end(), w.frontier.begin(), w.frontier.end());
             }
         }
 
+        /**
+         * Run every colouring, in each direction, on its own thread. They
+         * share the incumbent, and whoever finishes first has solved the
+         * problem, so the others give up.
+         */
+        auto run_portfolio(const std::vector<Subsearch<n_words_> > & starts) -> void
+        {
+            std::vector<Worker<n_words_, IndexType_> > workers;
+            for (bool iterate_backwards : { false, true })
+                for (auto how_much_sorting : { Params::no_sorting, Params::defer1, Params::full_sort, Params::renumber }) {
+                    workers.emplace_back(graph.size());
+                    configure(workers.back(), how_much_sorting, iterate_backwards);
+                }
+
+            std::vector<std::thread> threads;
+            for (auto & w : workers)
+                threads.emplace_back([&] {
+                        std::vector<unsigned> c;
+                        c.reserve(graph.size());
+                        for (auto & start : starts)
+                            search_from(w, c, start);
+                        flush_nodes(w);
+
+                        if (! params.abort->load())
+                            portfolio_done = true;
+                        w.time = duration_cast<milliseconds>(steady_clock::now() - params.start_time);
+                        });
+
+            for (auto & t : threads)
+                t.join();
+
+            for (auto & w : workers)
+                thread_times.push_back(w.time);
+        }
+
         auto run() -> Result
         {
             std::vector<unsigned> c;
             c.reserve(graph.size());
 
-            FixedBitSet<n_words_> p;
-            p.set_up_to(graph.size());
-
             incumbent.value = params.prime;
 
+            // start from the top, or from wherever a checkpoint says is left
+            std::vector<Subsearch<n_words_> > starts;
+            if (params.resume) {
+                nodes = params.resume->nodes;
+                for (auto & v : params.resume->incumbent)
+                    incumbent.c.push_back(invorder[v]);
+                incumbent.value = std::max<unsigned>(incumbent.value, incumbent.c.size());
+
+                for (auto & s : params.resume->frontier) {
+                    starts.emplace_back();
+                    for (auto & v : s.c)
+                        starts.back().c.push_back(invorder[v]);
+                    for (auto & v : s.p)
+                        starts.back().p.set(invorder[v]);
+
+                    // don't trust p to be made up of common neighbours
+                    for (auto & v : starts.back().c)
+                        graph.intersect_with_row(v, starts.back().p);
+                }
+            }
+            else {
+                starts.emplace_back();
+                starts.back().p.set_up_to(graph.size());
+            }
+
+            if (params.heuristic_time.count() > 0)
+                heuristic();
+
             // go!
-            expand(c, p);
+            if (params.portfolio)
+                run_portfolio(starts);
+            else if (params.n_threads > 1)
+                run_parallel(c, starts);
+            else {
+                Worker<n_words_, IndexType_> worker(graph.size());
+                configure(worker, params.how_much_sorting, params.iterate_backwards);
+                if (0 != params.decide_from) {
+                    worker.level_nodes.resize(params.decide + 1);
+                    decision_nodes.resize(params.decide + 1);
+                }
+                for (auto & start : starts)
+                    search_from(worker, c, start);
+                flush_nodes(worker);
+                frontier = std::move(worker.frontier);
+
+                // anything we haven't answered, we've searched all of
+                if (0 != params.decide_from) {
+                    unsigned long long n = 0;
+                    for (unsigned omega = params.decide ; omega > incumbent.value ; --omega)
+                        decision_nodes[omega] = (n += worker.level_nodes[omega]);
+                }
+            }
 
             Result result;
             result.nodes = nodes;
+            if (0 != params.decide_from)
+                for (unsigned omega = params.decide_from ; omega <= params.decide ; ++omega)
+                    result.decisions.emplace_back(omega <= incumbent.value, decision_nodes[omega]);
             for (auto & v : incumbent.c)
                 result.clique.insert(order[v]);
 
+            if (! thread_times.empty()) {
+                result.times.push_back(duration_cast<milliseconds>(steady_clock::now() - params.start_time));
+                result.times.insert(result.times.end(), thread_times.begin(), thread_times.end());
+            }
+
+            for (auto & s : frontier) {
+                result.frontier.emplace_back();
+                for (auto & v : s.c)
+                    result.frontier.back().c.push_back(order[v]);
+                s.p.for_each_set_bit([&] (int v) { result.frontier.back().p.push_back(order[v]); });
+            }
+
             return result;
         }
     };
-
-    template <template <unsigned> class SGI_>
-    struct Apply
-    {
-        template <unsigned size_, typename> using Type = SGI_<size_>;
-    };
 }
 
 auto clique(const Graph & graph, const Params & params) -> Result
 {
-    return select_graph_size<Apply<Clique>::template Type, Result>(AllGraphSizes(), graph, params);
+    if (params.runtime_sized_bitsets)
+        return select_graph_size<Clique, Result>(NoMoreGraphSizes(), graph, params);
+    else
+        return select_graph_size<Clique, Result>(AllGraphSizes(), graph, params);
 }
 
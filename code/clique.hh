@@ -3,18 +3,10 @@
 #ifndef CODE_GUARD_CLIQUE_HH
 #define CODE_GUARD_CLIQUE_HH 1
 
+#include "graph.hh"
 #include "params.hh"
 #include "result.hh"
 
-#include <vector>
-#include <set>
-
-struct Graph
-{
-    unsigned size = 0;
-    std::vector<std::set<unsigned> > edges;
-};
-
 auto clique(const Graph & graph, const Params & params) -> Result;
 
 #endif
@@ -0,0 +1,81 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "graph_file.hh"
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <cstdlib>
+
+namespace po = boost::program_options;
+
+auto main(int argc, char * argv[]) -> int
+{
+    try {
+        po::options_description display_options{ "Program options" };
+        display_options.add_options()
+            ("help",                                  "Display help information")
+            ("bit-rows",                              "Include an adjacency matrix in the output")
+            ;
+
+        po::options_description all_options{ "All options" };
+        all_options.add_options()
+            ("input",              po::value<std::string>(), "The graph file to read (DIMACS or binary)")
+            ("output",             po::value<std::string>(), "The binary graph file to write")
+            ;
+
+        all_options.add(display_options);
+
+        po::positional_options_description positional_options;
+        positional_options
+            .add("input", 1)
+            .add("output", 1)
+            ;
+
+        po::variables_map options_vars;
+        po::store(po::command_line_parser(argc, argv)
+                .options(all_options)
+                .positional(positional_options)
+                .run(), options_vars);
+        po::notify(options_vars);
+
+        /* --help? Show a message, and exit. */
+        if (options_vars.count("help")) {
+            std::cout << "Usage: " << argv[0] << " [options] input output" << std::endl;
+            std::cout << std::endl;
+            std::cout << display_options << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        /* No files specified? Show a message and exit. */
+        if (! options_vars.count("input") || ! options_vars.count("output")) {
+            std::cout << "Usage: " << argv[0] << " [options] input output" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        auto graph = read_graph_file(options_vars["input"].as<std::string>());
+
+        std::ofstream outfile{ options_vars["output"].as<std::string>(), std::ios::binary };
+        write_binary_graph(outfile, graph, options_vars.count("bit-rows"));
+        outfile.close();
+
+        if (! outfile) {
+            std::cerr << "Error: unable to write '" << options_vars["output"].as<std::string>() << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+    catch (const po::error & e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Try " << argv[0] << " --help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception & e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
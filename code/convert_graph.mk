@@ -0,0 +1,9 @@
+TARGET := convert_graph
+
+SOURCES := \
+    convert_graph.cc
+
+TGT_LDLIBS := $(boost_ldlibs) -lmax_clique
+TGT_LDFLAGS := -L${TARGET_DIR}
+TGT_PREREQS := libmax_clique.a
+
@@ -1,22 +1,129 @@
 /* vim: set sw=4 sts=4 et foldmethod=syntax : */
 
+#include "graph_file.hh"
+
 #include <boost/program_options.hpp>
 
 #include <iostream>
 #include <exception>
 #include <cstdlib>
+#include <cmath>
+#include <cstdint>
 #include <set>
 #include <random>
+#include <string>
+#include <thread>
+#include <atomic>
 
 namespace po = boost::program_options;
 
+namespace
+{
+    /* How many vertex pairs go in each block of a fast graph. This is part
+     * of what defines the graph, so it mustn't depend upon the number of
+     * threads. */
+    const unsigned long long pairs_per_block = 1ull << 22;
+
+    /* Below this density, fast graphs jump from edge to edge, rather than
+     * looking at every pair. */
+    const double skip_below_density = 0.1;
+
+    /* Flush text output once this much has built up. */
+    const std::string::size_type output_buffer_size = 1 << 20;
+
+    /* Roughly the most fast output we hold on to at once, across every
+     * thread, before writing it out. */
+    const unsigned long long wave_buffer_size = 1ull << 29;
+
+    auto append_number(std::string & out, unsigned long long n) -> void
+    {
+        char digits[20];
+        int len = 0;
+        do {
+            digits[len++] = '0' + n % 10;
+            n /= 10;
+        } while (0 != n);
+        while (len > 0)
+            out.push_back(digits[--len]);
+    }
+
+    /* Every edge of one block of the pair space, in the order (0, 1), (0,
+     * 2), ..., (0, n - 1), (1, 2), .... Each block has its own generator,
+     * seeded from the seed and the block number, so blocks can be made in
+     * any order, on any thread. */
+    template <typename Edge_>
+    auto generate_block(unsigned long long n, double p, int seed, unsigned long long block, const Edge_ & edge) -> void
+    {
+        unsigned long long total = n * (n - 1) / 2;
+        unsigned long long start = block * pairs_per_block, end = std::min(total, start + pairs_per_block);
+
+        // find the pair numbered start: row e begins at e * (2n - e - 1) / 2
+        unsigned long long lo = 0, hi = n - 1;
+        while (lo + 1 < hi) {
+            unsigned long long mid = (lo + hi) / 2;
+            if (mid * (2 * n - mid - 1) / 2 <= start)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        unsigned long long e = lo, f = e + 1 + (start - e * (2 * n - e - 1) / 2);
+
+        std::seed_seq seeds{ std::uint32_t(seed), std::uint32_t(block >> 32), std::uint32_t(block) };
+        std::mt19937_64 rand(seeds);
+
+        if (p >= skip_below_density) {
+            // look at every pair, comparing against p scaled up to 64 bits
+            bool always = p >= 1.0;
+            unsigned long long threshold = always ? 0 : (unsigned long long)(p * 18446744073709551616.0);
+            for (unsigned long long k = start ; k < end ; ++k) {
+                if (always || rand() < threshold)
+                    edge(e, f);
+                if (++f == n) {
+                    ++e;
+                    f = e + 1;
+                }
+            }
+        }
+        else if (p > 0.0) {
+            // the gap to the next edge is geometrically distributed
+            double log_q = std::log1p(-p);
+            for (unsigned long long k = start ; ; ) {
+                double u = (rand() >> 11) / 9007199254740992.0;
+                double skip = std::floor(std::log1p(-u) / log_q);
+                if (skip >= double(end - k))
+                    break;
+
+                k += (unsigned long long)(skip);
+                f += (unsigned long long)(skip);
+                while (f >= n) {
+                    unsigned long long over = f - n;
+                    ++e;
+                    f = e + 1 + over;
+                }
+
+                edge(e, f);
+
+                if (++k >= end)
+                    break;
+                if (++f == n) {
+                    ++e;
+                    f = e + 1;
+                }
+            }
+        }
+    }
+}
+
 auto main(int argc, char * argv[]) -> int
 {
     try {
         po::options_description display_options{ "Program options" };
         display_options.add_options()
             ("help",                                  "Display help information")
-            ("format",      po::value<std::string>(), "Specify the format of the output")
+            ("format",      po::value<std::string>(), "Specify the format of the output (dimacs, pairs0 or binary)")
+            ("bit-rows",                              "Include an adjacency matrix in binary output")
+            ("fast",                                  "Generate a different graph for each seed, much more quickly, skipping between edges of sparse graphs")
+            ("threads",     po::value<int>(),         "With --fast, use this many threads (0 for one per core); this doesn't change the graph")
             ;
 
         po::options_description all_options{ "All options" };
@@ -60,31 +167,137 @@ auto main(int argc, char * argv[]) -> int
         double p = options_vars["p"].as<double>();
         int s = options_vars["s"].as<int>();
 
-        std::mt19937 rand;
-        rand.seed(s);
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        if (n < 0) {
+            std::cout << "The number of vertices can't be negative" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        unsigned n_threads = 1;
+        if (options_vars.count("threads")) {
+            if (! options_vars.count("fast")) {
+                std::cout << "--threads can only be used with --fast" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            int threads = options_vars["threads"].as<int>();
+            if (threads < 0) {
+                std::cout << "The number of threads can't be negative" << std::endl;
+                return EXIT_FAILURE;
+            }
+            n_threads = 0 == threads ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+        }
 
-        std::function<void (int, int)> output_function;
+        /* Text output goes through our own buffer, rather than being
+         * flushed after every edge. */
+        std::ios::sync_with_stdio(false);
+        std::string buffer;
+        auto flush_buffer = [&] {
+            std::cout.write(buffer.data(), buffer.size());
+            buffer.clear();
+        };
+
+        std::function<void (std::string &, int, int)> output_function;
+
+        bool binary = false;
+        GraphBuilder binary_graph(n);
 
         if (! options_vars.count("format") || options_vars["format"].as<std::string>() == "dimacs") {
-            std::cout << "p edge " << n << " 0" << std::endl;
-            output_function = [] (int e, int f) { std::cout << "e " << e << " " << f << std::endl; };
+            std::cout << "p edge " << n << " 0\n";
+            output_function = [] (std::string & out, int e, int f) {
+                out.append("e ");
+                append_number(out, e);
+                out.push_back(' ');
+                append_number(out, f);
+                out.push_back('\n');
+            };
         }
         else if (options_vars["format"].as<std::string>() == "pairs0") {
-            std::cout << n << " 0" << std::endl;
-            output_function = [] (int e, int f) { std::cout << e - 1 << " " << f - 1 << std::endl; };
+            std::cout << n << " 0\n";
+            output_function = [] (std::string & out, int e, int f) {
+                append_number(out, e - 1);
+                out.push_back(' ');
+                append_number(out, f - 1);
+                out.push_back('\n');
+            };
+        }
+        else if (options_vars["format"].as<std::string>() == "binary") {
+            binary = true;
         }
         else {
-            std::cout << "Unknown format (try 'dimacs' or 'pairs0')" << std::endl;
+            std::cout << "Unknown format (try 'dimacs', 'pairs0' or 'binary')" << std::endl;
             return EXIT_FAILURE;
         }
 
-        for (int e = 1 ; e <= n ; ++e) {
-            for (int f = e + 1 ; f <= n ; ++f) {
-                if (dist(rand) <= p)
-                    output_function(e, f);
+        if (options_vars.count("fast")) {
+            /* Make blocks a few at a time on every thread, then write them
+             * out in order. Dense graphs make big blocks, so we make fewer
+             * at once, to keep to our buffer size. */
+            unsigned long long total = (unsigned long long)(n) * (n > 0 ? n - 1 : 0) / 2;
+            unsigned long long n_blocks = (total + pairs_per_block - 1) / pairs_per_block;
+            double edge_size = binary ? sizeof(std::pair<unsigned, unsigned>) : 2 * std::to_string(n).size() + 4;
+            double block_size = std::max(1.0, pairs_per_block * std::min(1.0, std::max(0.0, p)) * edge_size);
+            unsigned long long wave_size = std::max(1.0, std::min(4.0 * n_threads, std::floor(wave_buffer_size / block_size)));
+
+            std::vector<std::string> texts(wave_size);
+            std::vector<std::vector<std::pair<unsigned, unsigned> > > edges(wave_size);
+
+            for (unsigned long long wave_start = 0 ; wave_start < n_blocks ; wave_start += wave_size) {
+                unsigned long long wave_end = std::min(n_blocks, wave_start + wave_size);
+                std::atomic<unsigned long long> next{ wave_start };
+
+                auto run_thread = [&] {
+                    for (unsigned long long b ; (b = next++) < wave_end ; ) {
+                        auto & text = texts[b - wave_start];
+                        auto & block_edges = edges[b - wave_start];
+                        if (binary)
+                            generate_block(n, p, s, b, [&] (unsigned e, unsigned f) { block_edges.emplace_back(e, f); });
+                        else
+                            generate_block(n, p, s, b, [&] (unsigned e, unsigned f) { output_function(text, e + 1, f + 1); });
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                for (unsigned t = 1 ; t < n_threads ; ++t)
+                    threads.emplace_back(run_thread);
+                run_thread();
+                for (auto & t : threads)
+                    t.join();
+
+                for (unsigned long long b = wave_start ; b < wave_end ; ++b) {
+                    if (binary) {
+                        for (auto & e : edges[b - wave_start])
+                            binary_graph.add_edge(e.first, e.second);
+                        std::vector<std::pair<unsigned, unsigned> >().swap(edges[b - wave_start]);
+                    }
+                    else {
+                        std::cout.write(texts[b - wave_start].data(), texts[b - wave_start].size());
+                        texts[b - wave_start].clear();
+                    }
+                }
             }
         }
+        else {
+            random_graph_edges(n, p, s, [&] (int e, int f) {
+                    if (binary)
+                        binary_graph.add_edge(e, f);
+                    else {
+                        output_function(buffer, e + 1, f + 1);
+                        if (buffer.size() >= output_buffer_size)
+                            flush_buffer();
+                    }
+                    });
+            flush_buffer();
+        }
+
+        if (binary) {
+            write_binary_graph(std::cout, binary_graph.build(), options_vars.count("bit-rows"));
+        }
+
+        std::cout.flush();
+        if (! std::cout) {
+            std::cerr << "Error: unable to write graph" << std::endl;
+            return EXIT_FAILURE;
+        }
 
         return EXIT_SUCCESS;
     }
@@ -98,4 +311,3 @@ auto main(int argc, char * argv[]) -> int
         return EXIT_FAILURE;
     }
 }
-
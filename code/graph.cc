@@ -0,0 +1,134 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "graph.hh"
+#include "bit_graph.hh"
+
+#include <algorithm>
+#include <random>
+
+GraphBuilder::GraphBuilder(unsigned size) :
+    _size(size)
+{
+}
+
+namespace
+{
+    struct AdjacencyLists
+    {
+        std::vector<unsigned long long> offsets;
+        std::vector<unsigned> neighbours;
+    };
+
+    /* Rows have been laid out, possibly unsorted and with duplicates, so
+     * sort each row, squeeze out duplicates, and make a graph. */
+    auto sort_rows(unsigned size, std::vector<unsigned long long> && offsets, std::vector<unsigned> && neighbours) -> Graph
+    {
+        unsigned long long to = 0;
+        for (unsigned v = 0 ; v < size ; ++v) {
+            auto row_begin = neighbours.begin() + offsets[v], row_end = neighbours.begin() + offsets[v + 1];
+            std::sort(row_begin, row_end);
+            row_end = std::unique(row_begin, row_end);
+
+            offsets[v] = to;
+            to = std::copy(row_begin, row_end, neighbours.begin() + to) - neighbours.begin();
+        }
+        offsets[size] = to;
+        neighbours.resize(to);
+        neighbours.shrink_to_fit();
+
+        return adjacency_lists_graph(size, std::move(offsets), std::move(neighbours));
+    }
+}
+
+auto GraphBuilder::add_edges(std::vector<std::pair<unsigned, unsigned> > && edges) -> void
+{
+    if (_edges.empty())
+        _edges.swap(edges);
+    else
+        _more_edges.push_back(std::move(edges));
+}
+
+auto GraphBuilder::build() -> Graph
+{
+    // count both directions of every edge, then lay the rows out
+    std::vector<unsigned long long> offsets(_size + 1, 0);
+    auto count = [&] (const std::vector<std::pair<unsigned, unsigned> > & edges) {
+        for (auto & e : edges) {
+            ++offsets[e.first + 1];
+            ++offsets[e.second + 1];
+        }
+    };
+    count(_edges);
+    for (auto & edges : _more_edges)
+        count(edges);
+    for (unsigned v = 0 ; v < _size ; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<unsigned> neighbours(offsets[_size]);
+    std::vector<unsigned long long> fill(offsets.begin(), offsets.end() - 1);
+    auto lay_out = [&] (std::vector<std::pair<unsigned, unsigned> > & edges) {
+        for (auto & e : edges) {
+            neighbours[fill[e.first]++] = e.second;
+            neighbours[fill[e.second]++] = e.first;
+        }
+        std::vector<std::pair<unsigned, unsigned> >().swap(edges);
+    };
+    lay_out(_edges);
+    for (auto & edges : _more_edges)
+        lay_out(edges);
+    _more_edges.clear();
+
+    return sort_rows(_size, std::move(offsets), std::move(neighbours));
+}
+
+auto adjacency_lists_graph(unsigned size, std::vector<unsigned long long> && offsets, std::vector<unsigned> && neighbours) -> Graph
+{
+    auto lists = std::make_shared<AdjacencyLists>();
+    lists->offsets = std::move(offsets);
+    lists->neighbours = std::move(neighbours);
+
+    Graph result;
+    result.size = size;
+    result.offsets = lists->offsets.data();
+    result.neighbours = lists->neighbours.data();
+    result.storage = lists;
+    return result;
+}
+
+auto to_adjacency_lists(const Graph & graph) -> Graph
+{
+    if (graph.offsets)
+        return graph;
+    else if (graph.bit_rows) {
+        GraphBuilder builder(graph.size);
+        for (unsigned v = 0 ; v < graph.size ; ++v)
+            for (unsigned w = 0 ; w < graph.bit_row_words ; ++w)
+                for (BitWord b = graph.bit_rows[v * graph.bit_row_words + w] ; 0 != b ; b &= b - 1) {
+                    unsigned u = w * bits_per_word + __builtin_ctzll(b);
+                    if (u > v)
+                        builder.add_edge(v, u);
+                }
+        return builder.build();
+    }
+    else
+        return graph;
+}
+
+auto random_graph_edges(unsigned size, double p, int seed, const std::function<void (int, int)> & edge) -> void
+{
+    std::mt19937 rand;
+    rand.seed(seed);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    for (unsigned e = 0 ; e < size ; ++e)
+        for (unsigned f = e + 1 ; f < size ; ++f)
+            if (dist(rand) <= p)
+                edge(e, f);
+}
+
+auto random_graph(unsigned size, double p, int seed) -> Graph
+{
+    GraphBuilder builder(size);
+    random_graph_edges(size, p, seed, [&] (int e, int f) { builder.add_edge(e, f); });
+    return builder.build();
+}
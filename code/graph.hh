@@ -0,0 +1,155 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#ifndef CODE_GUARD_GRAPH_HH
+#define CODE_GUARD_GRAPH_HH 1
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+struct Graph
+{
+    unsigned size = 0;
+
+    /**
+     * Adjacency lists, in compressed sparse row form: the neighbours of
+     * vertex v are neighbours[offsets[v]] up to (but not including)
+     * neighbours[offsets[v + 1]], in ascending order and without
+     * duplicates. Every edge is stored in both directions. The memory is
+     * kept alive by storage, or by whoever made the graph, and might be
+     * part of a mapped file.
+     */
+    const unsigned long long * offsets = nullptr;
+    const unsigned * neighbours = nullptr;
+
+    /**
+     * If this is set, it holds the rows of an adjacency matrix (in the same
+     * format as a bit graph), each of bit_row_words words. Offsets and
+     * neighbours might also be set, or might be left null. The memory is
+     * kept alive by storage.
+     */
+    const unsigned long long * bit_rows = nullptr;
+    unsigned bit_row_words = 0;
+    std::shared_ptr<const void> storage;
+
+    /**
+     * How many neighbours does v have? Only if we have adjacency lists.
+     */
+    auto degree(unsigned v) const -> unsigned
+    {
+        return offsets[v + 1] - offsets[v];
+    }
+};
+
+/**
+ * Collects edges in any order, possibly repeated, and then turns them into
+ * adjacency lists.
+ */
+class GraphBuilder
+{
+    private:
+        unsigned _size;
+        std::vector<std::pair<unsigned, unsigned> > _edges;
+        std::vector<std::vector<std::pair<unsigned, unsigned> > > _more_edges;
+
+    public:
+        explicit GraphBuilder(unsigned size);
+
+        /**
+         * Add an edge between a and b (0-indexed).
+         */
+        auto add_edge(unsigned a, unsigned b) -> void
+        {
+            _edges.emplace_back(a, b);
+        }
+
+        /**
+         * Add a whole list of edges at once, such as one collected by
+         * another thread.
+         */
+        auto add_edges(std::vector<std::pair<unsigned, unsigned> > && edges) -> void;
+
+        /**
+         * Produce the graph. The builder is left empty.
+         */
+        auto build() -> Graph;
+};
+
+/**
+ * A graph which owns the adjacency lists it points to.
+ */
+auto adjacency_lists_graph(unsigned size, std::vector<unsigned long long> && offsets, std::vector<unsigned> && neighbours) -> Graph;
+
+/**
+ * Turn any graph into adjacency lists, if it doesn't have them already.
+ */
+auto to_adjacency_lists(const Graph & graph) -> Graph;
+
+/**
+ * Call edge with every edge (0-indexed, in ascending order) of a G(size, p)
+ * random graph, exactly as create_random_graph writes them out for the same
+ * seed.
+ */
+auto random_graph_edges(unsigned size, double p, int seed, const std::function<void (int, int)> & edge) -> void;
+
+/**
+ * The same random graph, as adjacency lists.
+ */
+auto random_graph(unsigned size, double p, int seed) -> Graph;
+
+/**
+ * Batagelj and Zaversnik's bucket algorithm. Repeatedly remove a vertex of
+ * smallest remaining degree: the order we remove them in is a degeneracy
+ * ordering, and the remaining degree of a vertex when it goes is its core
+ * number. Core numbers never decrease along the ordering.
+ *
+ * On entry core holds the degree of every vertex, and on exit it holds
+ * core numbers. for_each_neighbour(v, f) must call f with every neighbour
+ * of v.
+ */
+template <typename ForEachNeighbour_>
+auto core_decomposition(std::vector<unsigned> & core, std::vector<unsigned> & ordering, const ForEachNeighbour_ & for_each_neighbour) -> void
+{
+    unsigned n = core.size(), max_degree = 0;
+    for (unsigned v = 0 ; v < n ; ++v)
+        max_degree = std::max(max_degree, core[v]);
+
+    // vertices sorted by degree, with where each degree's bucket starts
+    std::vector<unsigned> bucket_starts(max_degree + 1, 0), position(n);
+    ordering.resize(n);
+    for (unsigned v = 0 ; v < n ; ++v)
+        ++bucket_starts[core[v]];
+    for (unsigned d = 0, start = 0 ; d <= max_degree ; ++d) {
+        unsigned n_this_degree = bucket_starts[d];
+        bucket_starts[d] = start;
+        start += n_this_degree;
+    }
+    for (unsigned v = 0 ; v < n ; ++v) {
+        position[v] = bucket_starts[core[v]]++;
+        ordering[position[v]] = v;
+    }
+    for (unsigned d = max_degree ; d >= 1 ; --d)
+        bucket_starts[d] = bucket_starts[d - 1];
+    bucket_starts[0] = 0;
+
+    for (unsigned i = 0 ; i < n ; ++i) {
+        unsigned v = ordering[i];
+        for_each_neighbour(v, [&] (unsigned w) {
+                if (core[w] <= core[v])
+                    return;
+
+                // move w to the front of its bucket, and then out of it
+                unsigned d = core[w], front = bucket_starts[d], u = ordering[front];
+                if (u != w) {
+                    std::swap(ordering[front], ordering[position[w]]);
+                    std::swap(position[u], position[w]);
+                }
+                ++bucket_starts[d];
+                --core[w];
+                });
+    }
+}
+
+#endif
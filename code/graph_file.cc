@@ -0,0 +1,459 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "graph_file.hh"
+#include "bit_graph.hh"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+GraphFileError::GraphFileError(const std::string & filename, const std::string & message) throw () :
+    _what("Error reading graph file '" + filename + "': " + message)
+{
+}
+
+auto GraphFileError::what() const throw () -> const char *
+{
+    return _what.c_str();
+}
+
+namespace
+{
+    /* The entire contents of a file, read only. Regular files are mapped
+     * into memory, and anything else (such as the pipe we get from process
+     * substitution) is read into a buffer instead. */
+    class FileContents
+    {
+        private:
+            void * _mapping = nullptr;
+            std::size_t _mapping_size = 0;
+            std::string _buffer;
+
+            const char * _data = nullptr;
+            std::size_t _size = 0;
+
+        public:
+            FileContents(const std::string & filename);
+            ~FileContents();
+
+            FileContents(const FileContents &) = delete;
+            FileContents & operator= (const FileContents &) = delete;
+
+            auto begin() const -> const char *
+            {
+                return _data;
+            }
+
+            auto end() const -> const char *
+            {
+                return _data + _size;
+            }
+    };
+
+    FileContents::FileContents(const std::string & filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (-1 == fd)
+            throw GraphFileError{ filename, "unable to open file" };
+
+        struct stat st;
+        if (0 == ::fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+            _mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED == _mapping)
+                _mapping = nullptr;
+            else {
+                _mapping_size = st.st_size;
+                ::madvise(_mapping, _mapping_size, MADV_SEQUENTIAL);
+                _data = static_cast<const char *>(_mapping);
+                _size = _mapping_size;
+            }
+        }
+
+        if (! _mapping) {
+            char chunk[1 << 16];
+            while (true) {
+                auto n = ::read(fd, chunk, sizeof(chunk));
+                if (n > 0)
+                    _buffer.append(chunk, n);
+                else if (0 == n)
+                    break;
+                else if (EINTR != errno) {
+                    ::close(fd);
+                    throw GraphFileError{ filename, "error reading file" };
+                }
+            }
+            _data = _buffer.data();
+            _size = _buffer.size();
+        }
+
+        ::close(fd);
+    }
+
+    FileContents::~FileContents()
+    {
+        if (_mapping)
+            ::munmap(_mapping, _mapping_size);
+    }
+
+    /* Whitespace, as far as a single line is concerned. */
+    auto is_space(char c) -> bool
+    {
+        return ' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c;
+    }
+
+    /* Skip at least one whitespace character. */
+    auto skip_spaces(const char * & p, const char * end) -> bool
+    {
+        if (p == end || ! is_space(*p))
+            return false;
+        while (p != end && is_space(*p))
+            ++p;
+        return true;
+    }
+
+    /* Read an unsigned number, which must have at least one digit. Values
+     * that don't fit are clamped, so they are reported as out of bounds
+     * rather than wrapping around. */
+    auto parse_number(const char * & p, const char * end, unsigned long long & result) -> bool
+    {
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        result = 0;
+        while (p != end && *p >= '0' && *p <= '9') {
+            result = std::min<unsigned long long>(result * 10 + (*p - '0'), std::numeric_limits<unsigned>::max());
+            ++p;
+        }
+        return true;
+    }
+
+    /* Match a literal word. */
+    auto parse_word(const char * & p, const char * end, const char * word) -> bool
+    {
+        auto q = p;
+        for ( ; *word ; ++word, ++q)
+            if (q == end || *q != *word)
+                return false;
+        p = q;
+        return true;
+    }
+
+    /* p (edge|col) vertices [edges] */
+    auto parse_problem_line(const char * p, const char * end, unsigned long long & size) -> bool
+    {
+        unsigned long long edges;
+        if (! (parse_word(p, end, "p") && skip_spaces(p, end)
+                    && (parse_word(p, end, "edge") || parse_word(p, end, "col")) && skip_spaces(p, end)
+                    && parse_number(p, end, size) && skip_spaces(p, end)))
+            return false;
+        parse_number(p, end, edges);
+        while (p != end && is_space(*p))
+            ++p;
+        return p == end;
+    }
+
+    /* e a b */
+    auto parse_edge_line(const char * p, const char * end, unsigned long long & a, unsigned long long & b) -> bool
+    {
+        if (! (parse_word(p, end, "e") && skip_spaces(p, end)
+                    && parse_number(p, end, a) && skip_spaces(p, end)
+                    && parse_number(p, end, b)))
+            return false;
+        while (p != end && is_space(*p))
+            ++p;
+        return p == end;
+    }
+
+    /* Find the end of the line starting at line. */
+    auto find_line_end(const char * line, const char * end) -> const char *
+    {
+        auto line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        return line_end ? line_end : end;
+    }
+
+    /* Parse every line in [begin, end), which must start at the beginning
+     * of a line. The size is updated by problem lines, after which problem
+     * is called. Edges are checked against the size, and passed to edge
+     * 0-indexed. */
+    template <typename Problem_, typename Edge_>
+    auto parse_dimacs_lines(const std::string & filename, const char * begin, const char * end,
+            unsigned & size, const Problem_ & problem, const Edge_ & edge) -> void
+    {
+        for (const char * line = begin, * line_end ; line != end ; line = line_end + (line_end != end)) {
+            line_end = find_line_end(line, end);
+
+            if (line == line_end)
+                continue;
+
+            /* Lines are comments, a problem description (contains the number of
+             * vertices), or an edge. */
+            unsigned long long a, b;
+            if ('c' == *line && (line + 1 == line_end || is_space(line[1]))) {
+                /* Comment, ignore */
+            }
+            else if (parse_problem_line(line, line_end, a)) {
+                /* Problem. Specifies the size of the graph. Must happen exactly
+                 * once. */
+                if (0 != size)
+                    throw GraphFileError{ filename, "multiple 'p' lines encountered" };
+                if (a > unsigned(std::numeric_limits<int>::max()))
+                    throw GraphFileError{ filename, "line '" + std::string(line, line_end) + "' has too many vertices" };
+                size = a;
+                problem();
+            }
+            else if (parse_edge_line(line, line_end, a, b)) {
+                /* An edge. DIMACS files are 1-indexed. We assume we've already had
+                 * a problem line (if not our size will be 0, so we'll throw). */
+                if (0 == a || 0 == b || a > size || b > size)
+                    throw GraphFileError{ filename, "line '" + std::string(line, line_end) + "' edge index out of bounds" };
+                else if (a == b)
+                    throw GraphFileError{ filename, "line '" + std::string(line, line_end) + "' contains a loop" };
+                edge(a - 1, b - 1);
+            }
+            else
+                throw GraphFileError{ filename, "cannot parse line '" + std::string(line, line_end) + "'" };
+        }
+    }
+
+    auto read_dimacs(const std::string & filename, const FileContents & contents) -> Graph
+    {
+        unsigned size = 0;
+        GraphBuilder builder(size);
+
+        parse_dimacs_lines(filename, contents.begin(), contents.end(), size,
+                [&] { builder = GraphBuilder(size); },
+                [&] (unsigned a, unsigned b) { builder.add_edge(a, b); });
+
+        return builder.build();
+    }
+
+    /* Read the header of a DIMACS file, and then parse the edges using
+     * several threads at once, in line-aligned chunks, each into its own
+     * list. */
+    auto read_dimacs_parallel(const std::string & filename, const FileContents & contents, unsigned n_threads) -> Graph
+    {
+        unsigned size = 0;
+
+        /* Everything up to and including the problem line. */
+        const char * body = contents.begin(), * end = contents.end();
+        bool seen_problem = false;
+        while (body != end && ! seen_problem) {
+            const char * line_end = find_line_end(body, end);
+            parse_dimacs_lines(filename, body, line_end, size,
+                    [&] { seen_problem = true; },
+                    [&] (unsigned, unsigned) { });
+            body = line_end + (line_end != end);
+        }
+
+        /* Chunk boundaries, moved forward to the start of the next line. */
+        std::vector<const char *> boundaries;
+        boundaries.push_back(body);
+        for (unsigned t = 1 ; t < n_threads ; ++t) {
+            const char * b = find_line_end(std::max(body + (end - body) * t / n_threads, boundaries.back()), end);
+            boundaries.push_back(b + (b != end));
+        }
+        boundaries.push_back(end);
+
+        std::vector<std::vector<std::pair<unsigned, unsigned> > > edges(n_threads);
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 0 ; t < n_threads ; ++t)
+            threads.emplace_back([&, t] {
+                    try {
+                        unsigned chunk_size = size;
+                        parse_dimacs_lines(filename, boundaries[t], boundaries[t + 1], chunk_size,
+                                [] { }, [&] (unsigned a, unsigned b) { edges[t].emplace_back(a, b); });
+                    }
+                    catch (...) {
+                        std::unique_lock<std::mutex> guard(error_mutex);
+                        if (! error)
+                            error = std::current_exception();
+                    }
+                });
+
+        for (auto & t : threads)
+            t.join();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        GraphBuilder builder(size);
+        for (auto & e : edges)
+            builder.add_edges(std::move(e));
+        return builder.build();
+    }
+
+    /* The start of a binary graph file. */
+    struct BinaryGraphHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t size;
+        std::uint64_t n_neighbours;
+        std::uint64_t bit_row_words;
+    };
+
+    const constexpr char binary_graph_magic[8] = { 'C', 'L', 'Q', 'G', 'R', 'A', 'P', 'H' };
+    const constexpr std::uint32_t binary_graph_version = 1;
+    const constexpr std::uint32_t binary_graph_has_bit_rows = 1;
+
+    auto is_binary_graph(const FileContents & contents) -> bool
+    {
+        return std::size_t(contents.end() - contents.begin()) >= sizeof(binary_graph_magic)
+            && 0 == std::memcmp(contents.begin(), binary_graph_magic, sizeof(binary_graph_magic));
+    }
+
+    auto round_up_to_words(std::uint64_t bytes) -> std::uint64_t
+    {
+        return (bytes + sizeof(BitWord) - 1) / sizeof(BitWord) * sizeof(BitWord);
+    }
+
+    auto read_binary(const std::string & filename, const std::shared_ptr<const FileContents> & contents) -> Graph
+    {
+        std::uint64_t length = contents->end() - contents->begin();
+        if (length < sizeof(BinaryGraphHeader))
+            throw GraphFileError{ filename, "binary header is truncated" };
+
+        BinaryGraphHeader header;
+        std::memcpy(&header, contents->begin(), sizeof(header));
+        if (binary_graph_version != header.version)
+            throw GraphFileError{ filename, "unsupported binary format version " + std::to_string(header.version) };
+        if (header.size > unsigned(std::numeric_limits<int>::max()) || header.n_neighbours > std::numeric_limits<std::uint32_t>::max())
+            throw GraphFileError{ filename, "binary graph is too big" };
+
+        bool has_bit_rows = header.flags & binary_graph_has_bit_rows;
+        std::uint64_t expected_bit_row_words = (header.size + bits_per_word - 1) / bits_per_word;
+        if (has_bit_rows && header.bit_row_words != expected_bit_row_words)
+            throw GraphFileError{ filename, "binary bit rows have the wrong width" };
+
+        std::uint64_t offsets_at = sizeof(BinaryGraphHeader);
+        std::uint64_t neighbours_at = offsets_at + (header.size + 1) * sizeof(std::uint64_t);
+        std::uint64_t bit_rows_at = round_up_to_words(neighbours_at + header.n_neighbours * sizeof(std::uint32_t));
+        std::uint64_t expected_length = has_bit_rows ? bit_rows_at + header.size * header.bit_row_words * sizeof(BitWord) : bit_rows_at;
+        if (length != expected_length)
+            throw GraphFileError{ filename, "binary file has the wrong length" };
+
+        // everything is aligned in the file, and both mappings and buffers
+        // are suitably aligned in memory
+        auto offsets = reinterpret_cast<const std::uint64_t *>(contents->begin() + offsets_at);
+        auto neighbours = reinterpret_cast<const std::uint32_t *>(contents->begin() + neighbours_at);
+
+        if (0 != offsets[0] || header.n_neighbours != offsets[header.size])
+            throw GraphFileError{ filename, "binary offsets do not cover the neighbours" };
+
+        for (std::uint64_t v = 0 ; v < header.size ; ++v) {
+            if (offsets[v] > offsets[v + 1])
+                throw GraphFileError{ filename, "binary offsets for vertex " + std::to_string(v + 1) + " are not ascending" };
+            for (auto n = offsets[v] ; n < offsets[v + 1] ; ++n) {
+                if (neighbours[n] >= header.size || neighbours[n] == v)
+                    throw GraphFileError{ filename, "binary neighbours of vertex " + std::to_string(v + 1) + " are out of bounds" };
+                if (n > offsets[v] && neighbours[n - 1] >= neighbours[n])
+                    throw GraphFileError{ filename, "binary neighbours of vertex " + std::to_string(v + 1) + " are not ascending" };
+            }
+        }
+
+        // every edge must be stored both ways round. Visiting vertices in
+        // order, each vertex's list must be consumed in order too.
+        std::vector<std::uint64_t> cursors(offsets, offsets + header.size);
+        for (std::uint64_t v = 0 ; v < header.size ; ++v)
+            for (auto n = offsets[v] ; n < offsets[v + 1] ; ++n) {
+                auto w = neighbours[n];
+                if (cursors[w] == offsets[w + 1] || neighbours[cursors[w]] != v)
+                    throw GraphFileError{ filename, "binary edge between vertices " + std::to_string(v + 1) + " and "
+                        + std::to_string(w + 1) + " is only stored one way round" };
+                ++cursors[w];
+            }
+
+        // use the lists where they are, rather than copying them
+        Graph result;
+        result.size = header.size;
+        static_assert(sizeof(std::uint64_t) == sizeof(*result.offsets), "offsets must be 64 bit");
+        static_assert(sizeof(std::uint32_t) == sizeof(*result.neighbours), "neighbours must be 32 bit");
+        result.offsets = reinterpret_cast<const unsigned long long *>(offsets);
+        result.neighbours = reinterpret_cast<const unsigned *>(neighbours);
+        result.storage = contents;
+
+        if (has_bit_rows) {
+            // the rows must hold exactly the neighbours, in ascending
+            // order, and nothing past the last vertex
+            auto bit_rows = reinterpret_cast<const BitWord *>(contents->begin() + bit_rows_at);
+            for (std::uint64_t v = 0 ; v < header.size ; ++v) {
+                auto row = bit_rows + v * header.bit_row_words;
+                auto n = offsets[v];
+                for (std::uint64_t w = 0 ; w < header.bit_row_words ; ++w)
+                    for (BitWord b = row[w] ; 0 != b ; b &= b - 1) {
+                        if (n == offsets[v + 1] || neighbours[n] != w * bits_per_word + __builtin_ctzll(b))
+                            throw GraphFileError{ filename, "binary bit row for vertex " + std::to_string(v + 1) + " does not match its neighbours" };
+                        ++n;
+                    }
+                if (n != offsets[v + 1])
+                    throw GraphFileError{ filename, "binary bit row for vertex " + std::to_string(v + 1) + " does not match its neighbours" };
+            }
+
+            result.bit_rows = bit_rows;
+            result.bit_row_words = header.bit_row_words;
+        }
+
+        return result;
+    }
+}
+
+auto read_graph_file(const std::string & filename, unsigned load_threads) -> Graph
+{
+    auto contents = std::make_shared<const FileContents>(filename);
+
+    if (is_binary_graph(*contents))
+        return read_binary(filename, contents);
+    else if (load_threads > 1)
+        return read_dimacs_parallel(filename, *contents, load_threads);
+    else
+        return read_dimacs(filename, *contents);
+}
+
+auto write_binary_graph(std::ostream & stream, const Graph & original_graph, bool bit_rows) -> void
+{
+    auto graph = to_adjacency_lists(original_graph);
+
+    BinaryGraphHeader header;
+    std::memcpy(header.magic, binary_graph_magic, sizeof(binary_graph_magic));
+    header.version = binary_graph_version;
+    header.flags = bit_rows ? binary_graph_has_bit_rows : 0;
+    header.size = graph.size;
+    header.n_neighbours = graph.offsets ? graph.offsets[graph.size] : 0;
+    header.bit_row_words = bit_rows ? (graph.size + bits_per_word - 1) / bits_per_word : 0;
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    static_assert(sizeof(std::uint64_t) == sizeof(graph.offsets[0]), "offsets must be 64 bit");
+    static_assert(sizeof(std::uint32_t) == sizeof(graph.neighbours[0]), "neighbours must be 32 bit");
+    std::vector<unsigned long long> no_offsets(1, 0);
+    stream.write(reinterpret_cast<const char *>(graph.offsets ? graph.offsets : no_offsets.data()), (graph.size + 1) * sizeof(std::uint64_t));
+    stream.write(reinterpret_cast<const char *>(graph.neighbours), header.n_neighbours * sizeof(std::uint32_t));
+
+    std::uint64_t neighbours_end = sizeof(BinaryGraphHeader) + (graph.size + 1) * sizeof(std::uint64_t)
+        + header.n_neighbours * sizeof(std::uint32_t);
+    static const char padding[sizeof(BitWord)] = { };
+    stream.write(padding, round_up_to_words(neighbours_end) - neighbours_end);
+
+    if (bit_rows) {
+        std::vector<BitWord> row(header.bit_row_words);
+        for (unsigned v = 0 ; v < graph.size ; ++v) {
+            std::fill(row.begin(), row.end(), 0);
+            for (auto n = graph.offsets[v] ; n < graph.offsets[v + 1] ; ++n)
+                row[graph.neighbours[n] / bits_per_word] |= BitWord{ 1 } << (graph.neighbours[n] % bits_per_word);
+            stream.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(BitWord));
+        }
+    }
+}
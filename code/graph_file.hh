@@ -0,0 +1,46 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#ifndef CODE_GUARD_GRAPH_FILE_HH
+#define CODE_GUARD_GRAPH_FILE_HH 1
+
+#include "graph.hh"
+
+#include <string>
+#include <exception>
+#include <ostream>
+
+/**
+ * Thrown if we come across bad data in a graph file, or if we can't read a
+ * graph file.
+ */
+class GraphFileError :
+    public std::exception
+{
+    private:
+        std::string _what;
+
+    public:
+        GraphFileError(const std::string & filename, const std::string & message) throw ();
+
+        auto what() const throw () -> const char *;
+};
+
+/**
+ * Read a graph file, which may either be in DIMACS format or in our binary
+ * format. If load_threads is more than one, the edges of a DIMACS file are
+ * parsed in parallel.
+ */
+auto read_graph_file(const std::string & filename, unsigned load_threads = 1) -> Graph;
+
+/**
+ * Write a graph in our binary format. If bit_rows is set, an adjacency
+ * matrix is included too.
+ *
+ * The format, in host byte order, is a BinaryGraphHeader, then size + 1
+ * 64-bit offsets, then the 32-bit neighbours of each vertex in ascending
+ * order (padded to a multiple of eight bytes), then optionally size rows
+ * of bit_row_words 64-bit words.
+ */
+auto write_binary_graph(std::ostream & stream, const Graph & graph, bool bit_rows) -> void;
+
+#endif
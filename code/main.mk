@@ -1,17 +1,27 @@
 BUILD_DIR := intermediate
 TARGET_DIR := ./
-SUBMAKEFILES := file.mk create_random_graph.mk
+SUBMAKEFILES := file.mk create_random_graph.mk convert_graph.mk
 
-boost_ldlibs := -lboost_regex -lboost_thread -lboost_system -lboost_program_options
+boost_ldlibs := -lboost_thread -lboost_system -lboost_program_options
 
-override CXXFLAGS += -O3 -march=native -std=c++14 -I./ -W -Wall -g -ggdb3 -pthread
+# We don't use -march=native, so that binaries can be moved between machines.
+# The bitset kernels pick a vector instruction set at runtime instead.
+ifeq ($(shell uname -m),x86_64)
+    arch_cxxflags := -march=x86-64-v2
+endif
+
+override CXXFLAGS += -O3 $(arch_cxxflags) -std=c++14 -I./ -W -Wall -g -ggdb3 -pthread
 override LDFLAGS += -pthread
 
 TARGET := libmax_clique.a
 
 SOURCES := \
     clique.cc \
-    bit_graph.cc
+    bit_kernels.cc \
+    graph.cc \
+    graph_file.cc \
+    checkpoint.cc \
+    sparse_clique.cc
 
 TGT_LDLIBS := $(boost_ldlibs)
 
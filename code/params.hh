@@ -6,6 +6,8 @@
 #include <chrono>
 #include <atomic>
 
+struct Checkpoint;
+
 struct Params
 {
     /// If this is set to true, we should abort due to a time limit.
@@ -14,8 +16,17 @@ struct Params
     /// The start time of the algorithm.
     std::chrono::time_point<std::chrono::steady_clock> start_time;
 
+    /// How to order vertices before we start?
+    enum { degree_order, degeneracy_order, ex_degree_order, colour_order } initial_ordering = degree_order;
+
     /// How much sorting to do?
-    enum { no_sorting, defer1, full_sort } how_much_sorting = no_sorting;
+    enum { no_sorting, defer1, full_sort, renumber } how_much_sorting = no_sorting;
+
+    /// Only record vertices which might be branched on when colouring?
+    bool threshold_colouring = false;
+
+    /// Strengthen colour bounds using infra-chromatic unit propagation?
+    bool infra_chromatic = false;
 
     /// Iterate backwards?
     bool iterate_backwards = false;
@@ -23,14 +34,40 @@ struct Params
     /// Prime the incumbent?
     unsigned prime = 0;
 
+    /// If non-zero, prime the incumbent using a heuristic which runs for
+    /// up to this long.
+    std::chrono::milliseconds heuristic_time{ 0 };
+
     /// Decision problem instead?
     unsigned decide = 0;
 
+    /// If non-zero, answer the decision problem for every omega from this
+    /// up to decide, using one search. Only for sequential search.
+    unsigned decide_from = 0;
+
+    /// Print a line whenever we find a better incumbent?
+    bool print_incumbents = true;
+
     /// Measure Kendall tau?
     bool measure_kendall_tau = false;
 
     /// Shuffle before calculating tau?
     bool shuffle_before_tau = false;
+
+    /// Use runtime sized bitsets, even if a fixed size would fit?
+    bool runtime_sized_bitsets = false;
+
+    /// Run every colouring and direction at once, sharing an incumbent?
+    bool portfolio = false;
+
+    /// Number of threads to use (1 is sequential).
+    unsigned n_threads = 1;
+
+    /// If we abort, say what's left to do in the result?
+    bool record_frontier = false;
+
+    /// If set, carry on from here rather than starting from scratch.
+    const Checkpoint * resume = nullptr;
 };
 
 #endif
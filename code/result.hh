@@ -3,9 +3,13 @@
 #ifndef CODE_GUARD_RESULT_HH
 #define CODE_GUARD_RESULT_HH 1
 
+#include "checkpoint.hh"
+
 #include <set>
 #include <list>
 #include <chrono>
+#include <vector>
+#include <utility>
 
 struct Result
 {
@@ -20,6 +24,19 @@ struct Result
      * Additional values are for each worker thread.
      */
     std::list<std::chrono::milliseconds> times;
+
+    /**
+     * If we aborted and Params::record_frontier was set, everything which
+     * is still to be done.
+     */
+    std::vector<Subproblem> frontier;
+
+    /**
+     * If Params::decide_from was set, for each omega from decide_from up
+     * to decide, whether there is a clique that big, and how many nodes
+     * deciding that on its own would have taken.
+     */
+    std::vector<std::pair<bool, unsigned long long> > decisions;
 };
 
 #endif
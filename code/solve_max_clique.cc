@@ -1,12 +1,14 @@
 /* vim: set sw=4 sts=4 et foldmethod=syntax : */
 
 #include "clique.hh"
+#include "sparse_clique.hh"
+#include "graph_file.hh"
+#include "bit_kernels.hh"
+#include "checkpoint.hh"
 
 #include <boost/program_options.hpp>
-#include <boost/regex.hpp>
 
 #include <iostream>
-#include <fstream>
 #include <exception>
 #include <cstdlib>
 #include <chrono>
@@ -14,6 +16,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <sstream>
 
 namespace po = boost::program_options;
 
@@ -21,81 +26,18 @@ using std::chrono::steady_clock;
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
 
+/* If we're checkpointing, SIGTERM and SIGINT abort the search, rather than
+ * killing us, so that we get to write out what's left. */
 namespace
 {
-    class GraphFileError :
-        public std::exception
-    {
-        private:
-            std::string _what;
-
-        public:
-            GraphFileError(const std::string & filename, const std::string & message) throw ();
-
-            auto what() const throw () -> const char *;
-    };
-
-    GraphFileError::GraphFileError(const std::string & filename, const std::string & message) throw () :
-        _what("Error reading graph file '" + filename + "': " + message)
-    {
-    }
-
-    auto GraphFileError::what() const throw () -> const char *
-    {
-        return _what.c_str();
-    }
+    std::atomic<bool> * abort_on_signal = nullptr;
+    volatile std::sig_atomic_t signalled = 0;
 
-    auto read_dimacs(const std::string & filename) -> Graph
+    auto handle_signal(int) -> void
     {
-        Graph result;
-
-        std::ifstream infile{ filename };
-        if (! infile)
-            throw GraphFileError{ filename, "unable to open file" };
-
-        std::string line;
-        while (std::getline(infile, line)) {
-            if (line.empty())
-                continue;
-
-            /* Lines are comments, a problem description (contains the number of
-             * vertices), or an edge. */
-            static const boost::regex
-                comment{ R"(c(\s.*)?)" },
-                problem{ R"(p\s+(edge|col)\s+(\d+)\s+(\d+)?\s*)" },
-                edge{ R"(e\s+(\d+)\s+(\d+)\s*)" };
-
-            boost::smatch match;
-            if (regex_match(line, match, comment)) {
-                /* Comment, ignore */
-            }
-            else if (regex_match(line, match, problem)) {
-                /* Problem. Specifies the size of the graph. Must happen exactly
-                 * once. */
-                if (0 != result.size)
-                    throw GraphFileError{ filename, "multiple 'p' lines encountered" };
-                result.size = std::stoi(match.str(2));
-                result.edges.resize(result.size);
-            }
-            else if (regex_match(line, match, edge)) {
-                /* An edge. DIMACS files are 1-indexed. We assume we've already had
-                 * a problem line (if not our size will be 0, so we'll throw). */
-                int a{ std::stoi(match.str(1)) }, b{ std::stoi(match.str(2)) };
-                if (0 == a || 0 == b || unsigned(a) > result.size || unsigned(b) > result.size)
-                    throw GraphFileError{ filename, "line '" + line + "' edge index out of bounds" };
-                else if (a == b)
-                    throw GraphFileError{ filename, "line '" + line + "' contains a loop" };
-                result.edges[a - 1].insert(b - 1);
-                result.edges[b - 1].insert(a - 1);
-            }
-            else
-                throw GraphFileError{ filename, "cannot parse line '" + line + "'" };
-        }
-
-        if (! infile.eof())
-            throw GraphFileError{ filename, "error reading file" };
-
-        return result;
+        signalled = 1;
+        if (abort_on_signal)
+            abort_on_signal->store(true);
     }
 }
 
@@ -114,6 +56,9 @@ auto run_this_wrapped(const std::function<Result_ (const Data_ &, const Params_
         std::atomic<bool> abort;
         abort.store(false);
         params.abort = &abort;
+        abort_on_signal = &abort;
+        if (signalled)
+            abort.store(true);
         if (0 != timeout) {
             timeout_thread = std::thread([&] {
                     auto abort_time = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
@@ -133,20 +78,35 @@ auto run_this_wrapped(const std::function<Result_ (const Data_ &, const Params_
                     });
         }
 
+        /* Clean up the timeout thread, even if we're leaving because
+         * something threw. */
+        auto clean_up = [&] {
+            abort_on_signal = nullptr;
+            if (timeout_thread.joinable()) {
+                {
+                    std::unique_lock<std::mutex> guard(timeout_mutex);
+                    abort.store(true);
+                    timeout_cv.notify_all();
+                }
+                timeout_thread.join();
+            }
+        };
+
         /* Start the clock */
         params.start_time = std::chrono::steady_clock::now();
-        auto result = func(data, params);
-
-        /* Clean up the timeout thread */
-        if (timeout_thread.joinable()) {
-            {
-                std::unique_lock<std::mutex> guard(timeout_mutex);
-                abort.store(true);
-                timeout_cv.notify_all();
-            }
-            timeout_thread.join();
+        Result_ result;
+        try {
+            result = func(data, params);
+        }
+        catch (...) {
+            clean_up();
+            throw;
         }
 
+        clean_up();
+        if (signalled)
+            aborted = true;
+
         return result;
     };
 }
@@ -159,6 +119,109 @@ auto run_this(Result_ func(const Data_ &, const Params_ &)) -> std::function<Res
     return run_this_wrapped(std::function<Result_ (const Data_ &, const Params_ &)>(func));
 }
 
+/* Helper: how many threads does an option ask for? Zero means one per
+ * core, and anything negative is an error. */
+auto thread_count(const po::variables_map & options_vars, const std::string & name) -> unsigned
+{
+    int threads = options_vars[name].as<int>();
+    if (threads < 0)
+        throw po::error("the argument for option '--" + name + "' can't be negative");
+    return 0 == threads ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+}
+
+/* Solve lots of graphs in one process, on a pool of threads, writing one
+ * line per graph as each finishes: the file name, the clique size, the
+ * number of nodes, the runtime in milliseconds, and whether we aborted.
+ * Rather than one timeout thread per run, a single watchdog aborts
+ * whichever runs have gone on for too long. */
+auto run_batch(const std::vector<std::string> & files, const Params & params, bool sparse, int timeout, unsigned n_threads) -> int
+{
+    struct Slot
+    {
+        std::atomic<bool> abort{ false };
+        bool busy = false;
+        steady_clock::time_point abort_time;
+    };
+
+    std::vector<Slot> slots(n_threads);
+    std::mutex slots_mutex, output_mutex;
+    std::atomic<unsigned> next{ 0 };
+    std::atomic<bool> failed{ false };
+
+    auto run_thread = [&] (Slot & slot) {
+        while (true) {
+            unsigned i = next++;
+            if (i >= files.size())
+                break;
+
+            try {
+                Params instance_params = params;
+                instance_params.abort = &slot.abort;
+                instance_params.print_incumbents = false;
+
+                auto graph = read_graph_file(files[i]);
+                if (sparse)
+                    graph = to_adjacency_lists(graph);
+
+                {
+                    std::unique_lock<std::mutex> guard(slots_mutex);
+                    slot.abort = false;
+                    slot.busy = 0 != timeout;
+                    slot.abort_time = steady_clock::now() + std::chrono::seconds(timeout);
+                }
+
+                instance_params.start_time = steady_clock::now();
+                auto result = (sparse ? sparse_clique : clique)(graph, instance_params);
+                auto time = duration_cast<milliseconds>(steady_clock::now() - instance_params.start_time);
+
+                bool aborted;
+                {
+                    std::unique_lock<std::mutex> guard(slots_mutex);
+                    slot.busy = false;
+                    aborted = slot.abort.load();
+                }
+
+                std::unique_lock<std::mutex> guard(output_mutex);
+                std::cout << files[i] << " " << result.clique.size() << " " << result.nodes << " " << time.count();
+                if (aborted)
+                    std::cout << " aborted";
+                std::cout << std::endl;
+            }
+            catch (const std::exception & e) {
+                std::unique_lock<std::mutex> guard(output_mutex);
+                std::cerr << "Error: " << e.what() << std::endl;
+                failed = true;
+            }
+        }
+    };
+
+    std::atomic<bool> finished{ false };
+    std::thread watchdog;
+    if (0 != timeout)
+        watchdog = std::thread([&] {
+                while (! finished.load()) {
+                    std::this_thread::sleep_for(milliseconds(10));
+                    auto now = steady_clock::now();
+                    std::unique_lock<std::mutex> guard(slots_mutex);
+                    for (auto & slot : slots)
+                        if (slot.busy && now >= slot.abort_time)
+                            slot.abort = true;
+                }
+                });
+
+    std::vector<std::thread> threads;
+    for (auto & slot : slots)
+        threads.emplace_back(run_thread, std::ref(slot));
+    for (auto & t : threads)
+        t.join();
+
+    finished = true;
+    if (watchdog.joinable())
+        watchdog.join();
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 auto main(int argc, char * argv[]) -> int
 {
     try {
@@ -166,25 +229,43 @@ auto main(int argc, char * argv[]) -> int
         display_options.add_options()
             ("help",                                  "Display help information")
             ("timeout",            po::value<int>(),  "Abort after this many seconds")
+            ("order",              po::value<std::string>(), "Initial vertex ordering (degree, degeneracy, ex-degree or colour)")
             ("sdf",                                   "Smallest domain first (slow)")
             ("2df",                                   "Domains of size 2 first")
+            ("renumber",                              "Re-NUMBER recolouring of branching vertices")
             ("iterate-backwards",                     "Iterate backwards")
+            ("portfolio",                             "Run every colouring and direction on its own thread, stopping when one finishes")
+            ("threshold-colouring",                   "Only record vertices which the incumbent doesn't rule out when colouring")
+            ("infra-chromatic",                       "Strengthen colour bounds using infra-chromatic unit propagation")
             ("prime",              po::value<int>(),  "Set initial incumbent size")
+            ("heuristic",          po::value<int>(),  "Prime the incumbent using a heuristic which runs for up to this many milliseconds")
             ("tau",                                   "Measure Kendall tau")
             ("shuffle-before-tau",                    "Shuffle before calculating tau (useful for analysis only)")
             ("decide",             po::value<int>(),  "Solve the decision problem with this value of omega")
+            ("decide-range",       po::value<std::string>(), "Solve the decision problem for every omega from lo to hi, given as lo..hi, using one search")
+            ("threads",            po::value<int>(),  "Number of threads to use (0 for one per core)")
+            ("runtime-sized-bitsets",                 "Use runtime sized bitsets, even for graphs small enough for fixed sizes")
+            ("sparse",                                "Solve one small subproblem per vertex, for large sparse graphs")
+            ("kernels",            po::value<std::string>(), "Bitset kernels to use (scalar, avx2, avx512 or best)")
+            ("load-threads",       po::value<int>(),  "Parse a DIMACS input file using this many threads (0 for one per core)")
+            ("random",             po::value<std::vector<std::string> >()->multitoken(), "Instead of reading a file, solve the graph create_random_graph would write for n p seed")
+            ("checkpoint",         po::value<std::string>(), "Write what's left of the search to this file, if we are aborted by a timeout, SIGTERM or SIGINT")
+            ("resume",             po::value<std::string>(), "Carry on from this checkpoint file")
+            ("batch",                                 "Solve every file given, one result line each")
+            ("manifest",           po::value<std::string>(), "With --batch, also solve the files listed in this file, one per line")
+            ("batch-threads",      po::value<int>(),  "With --batch, solve this many files at once (0 for one per core)")
             ;
 
         po::options_description all_options{ "All options" };
         all_options.add_options()
-            ("file",    po::value<std::string>(), "Clique file")
+            ("file",    po::value<std::vector<std::string> >(), "Clique file (DIMACS or binary)")
             ;
 
         all_options.add(display_options);
 
         po::positional_options_description positional_options;
         positional_options
-            .add("file", 1)
+            .add("file", -1)
             ;
 
         po::variables_map options_vars;
@@ -202,51 +283,222 @@ auto main(int argc, char * argv[]) -> int
             return EXIT_SUCCESS;
         }
 
-        /* No input file specified? Show a message and exit. */
-        if (! options_vars.count("file")) {
+        /* No input file specified, or too many? Show a message and exit. */
+        bool batch = options_vars.count("batch");
+        std::vector<std::string> files;
+        if (options_vars.count("file"))
+            files = options_vars["file"].as<std::vector<std::string> >();
+        if (batch && options_vars.count("manifest")) {
+            auto filename = options_vars["manifest"].as<std::string>();
+            std::ifstream manifest{ filename };
+            if (! manifest) {
+                std::cerr << "Error: can't read manifest '" << filename << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            for (std::string line ; std::getline(manifest, line) ; )
+                if (! line.empty())
+                    files.push_back(line);
+        }
+
+        bool random = options_vars.count("random");
+        if (batch && random) {
+            std::cerr << "Error: --batch can't be used with --random" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (batch ? files.empty() : (random ? 0 : 1) != files.size()) {
             std::cout << "Usage: " << argv[0] << " [options] file" << std::endl;
+            std::cout << "       " << argv[0] << " [options] --random n p seed" << std::endl;
+            std::cout << "       " << argv[0] << " --batch [options] [--manifest manifest] file..." << std::endl;
             return EXIT_FAILURE;
         }
 
         /* Figure out what our options should be. */
         Params params;
 
+        if (options_vars.count("order")) {
+            auto order = options_vars["order"].as<std::string>();
+            if (order == "degree")
+                params.initial_ordering = Params::degree_order;
+            else if (order == "degeneracy")
+                params.initial_ordering = Params::degeneracy_order;
+            else if (order == "ex-degree")
+                params.initial_ordering = Params::ex_degree_order;
+            else if (order == "colour")
+                params.initial_ordering = Params::colour_order;
+            else {
+                std::cerr << "Error: unknown ordering '" << order << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
         if (options_vars.count("sdf"))
             params.how_much_sorting = Params::full_sort;
         else if (options_vars.count("2df"))
             params.how_much_sorting = Params::defer1;
+        else if (options_vars.count("renumber"))
+            params.how_much_sorting = Params::renumber;
 
         if (options_vars.count("iterate-backwards"))
             params.iterate_backwards = true;
 
+        params.portfolio = options_vars.count("portfolio");
+        if (params.portfolio && (options_vars.count("threads") || options_vars.count("checkpoint") || options_vars.count("resume")
+                    || options_vars.count("sparse"))) {
+            std::cerr << "Error: --portfolio can't be used with --threads, --checkpoint, --resume or --sparse" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        /* Only plain colouring, going forwards, can leave out vertices. */
+        params.threshold_colouring = options_vars.count("threshold-colouring");
+        if (params.threshold_colouring && (options_vars.count("2df") || options_vars.count("sdf") || options_vars.count("renumber")
+                    || params.iterate_backwards || params.portfolio || options_vars.count("tau") || options_vars.count("infra-chromatic"))) {
+            std::cerr << "Error: --threshold-colouring can't be used with --2df, --sdf, --renumber, --iterate-backwards, --portfolio, "
+                << "--tau or --infra-chromatic" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        params.infra_chromatic = options_vars.count("infra-chromatic");
+
         if (options_vars.count("prime"))
             params.prime = options_vars["prime"].as<int>();
 
+        if (options_vars.count("heuristic"))
+            params.heuristic_time = milliseconds(options_vars["heuristic"].as<int>());
+
         if (options_vars.count("decide")) {
             params.decide = options_vars["decide"].as<int>();
             if (! options_vars.count("prime"))
                 params.prime = params.decide - 1;
         }
 
+        if (options_vars.count("decide-range")) {
+            /* Each omega's search would differ only in its incumbent, so
+             * we can't use anything else which looks at the incumbent. */
+            if (options_vars.count("decide") || options_vars.count("prime") || options_vars.count("threads") || params.portfolio
+                    || options_vars.count("sparse") || options_vars.count("heuristic") || options_vars.count("renumber")
+                    || params.threshold_colouring || params.infra_chromatic || options_vars.count("tau")
+                    || options_vars.count("checkpoint") || options_vars.count("resume") || batch) {
+                std::cerr << "Error: --decide-range can't be used with --decide, --prime, --threads, --portfolio, --sparse, --heuristic, "
+                    << "--renumber, --threshold-colouring, --infra-chromatic, --tau, --checkpoint, --resume or --batch" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            auto range = options_vars["decide-range"].as<std::string>();
+            auto dots = range.find("..");
+            std::istringstream lo_stream{ range.substr(0, dots) }, hi_stream{ dots == std::string::npos ? "" : range.substr(dots + 2) };
+            int lo, hi;
+            if (! (lo_stream >> lo && lo_stream.eof() && hi_stream >> hi && hi_stream.eof() && 1 <= lo && lo <= hi)) {
+                std::cerr << "Error: --decide-range needs lo..hi, with 1 <= lo <= hi" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            params.decide_from = lo;
+            params.decide = hi;
+            params.prime = lo - 1;
+            params.print_incumbents = false;
+        }
+
         params.measure_kendall_tau = options_vars.count("tau");
         params.shuffle_before_tau = options_vars.count("shuffle-before-tau");
 
+        params.runtime_sized_bitsets = options_vars.count("runtime-sized-bitsets");
+
+        if (options_vars.count("threads"))
+            params.n_threads = thread_count(options_vars, "threads");
+
+        if (options_vars.count("kernels") && ! select_bit_kernels(options_vars["kernels"].as<std::string>())) {
+            std::cerr << "Error: bitset kernels '" << options_vars["kernels"].as<std::string>() << "' are not available" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        bool sparse = options_vars.count("sparse");
+        if (sparse && (options_vars.count("checkpoint") || options_vars.count("resume") || params.measure_kendall_tau
+                    || options_vars.count("heuristic"))) {
+            std::cerr << "Error: --sparse can't be used with --checkpoint, --resume, --tau or --heuristic" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        int timeout = options_vars.count("timeout") ? options_vars["timeout"].as<int>() : 0;
+
+        /* Lots of graphs? */
+        if (batch) {
+            if (options_vars.count("checkpoint") || options_vars.count("resume") || params.measure_kendall_tau
+                    || options_vars.count("load-threads")) {
+                std::cerr << "Error: --batch can't be used with --checkpoint, --resume, --tau or --load-threads" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            unsigned batch_threads = 1;
+            if (options_vars.count("batch-threads"))
+                batch_threads = thread_count(options_vars, "batch-threads");
+
+            return run_batch(files, params, sparse, timeout, batch_threads);
+        }
+
         /* Create graphs */
-        auto graph = read_dimacs(options_vars["file"].as<std::string>());
+        unsigned load_threads = 1;
+        if (options_vars.count("load-threads"))
+            load_threads = thread_count(options_vars, "load-threads");
+        Graph graph;
+        if (random) {
+            /* Generate the graph directly, rather than going through a
+             * DIMACS file. */
+            auto args = options_vars["random"].as<std::vector<std::string> >();
+            std::istringstream n_stream{ args.size() == 3 ? args[0] : "" }, p_stream{ args.size() == 3 ? args[1] : "" },
+                s_stream{ args.size() == 3 ? args[2] : "" };
+            int n, s;
+            double p;
+            if (! (n_stream >> n && n_stream.eof() && n >= 0 && p_stream >> p && p_stream.eof() && s_stream >> s && s_stream.eof())) {
+                std::cerr << "Error: --random needs n p seed" << std::endl;
+                return EXIT_FAILURE;
+            }
+            graph = random_graph(n, p, s);
+        }
+        else
+            graph = read_graph_file(files.front(), load_threads);
+
+        if (sparse)
+            graph = to_adjacency_lists(graph);
+
+        /* Carrying on from a checkpoint? */
+        Checkpoint resume;
+        if (options_vars.count("resume")) {
+            auto filename = options_vars["resume"].as<std::string>();
+            resume = read_checkpoint(filename);
+            check_checkpoint(filename, resume, graph);
+            params.resume = &resume;
+        }
+
+        if (options_vars.count("checkpoint")) {
+            params.record_frontier = true;
+            std::signal(SIGTERM, handle_signal);
+            std::signal(SIGINT, handle_signal);
+        }
 
         /* Do the actual run. */
         bool aborted = false;
         Result result;
 
-        result = run_this(clique)(
+        result = run_this(sparse ? sparse_clique : clique)(
                 graph,
                 params,
                 aborted,
-                options_vars.count("timeout") ? options_vars["timeout"].as<int>() : 0);
+                timeout);
 
         /* Stop the clock. */
         auto overall_time = duration_cast<milliseconds>(steady_clock::now() - params.start_time);
 
+        /* Deciding lots of omegas? One line for each. */
+        if (0 != params.decide_from) {
+            for (unsigned omega = params.decide_from ; omega <= params.decide ; ++omega) {
+                auto & decision = result.decisions[omega - params.decide_from];
+                std::cout << omega << " " << (decision.first ? "true" : aborted ? "aborted" : "false") << " " << decision.second << std::endl;
+            }
+            std::cout << overall_time.count() << std::endl;
+            return EXIT_SUCCESS;
+        }
+
         /* Display the results. */
         std::cout << result.clique.size() << " " << result.nodes;
 
@@ -268,6 +520,16 @@ auto main(int argc, char * argv[]) -> int
         }
         std::cout << std::endl;
 
+        /* Write out what's left, which is nothing if we weren't aborted. */
+        if (options_vars.count("checkpoint")) {
+            Checkpoint checkpoint;
+            checkpoint.graph_size = graph.size;
+            checkpoint.incumbent.assign(result.clique.begin(), result.clique.end());
+            checkpoint.nodes = result.nodes;
+            checkpoint.frontier = std::move(result.frontier);
+            write_checkpoint(options_vars["checkpoint"].as<std::string>(), checkpoint);
+        }
+
         return EXIT_SUCCESS;
     }
     catch (const po::error & e) {
@@ -0,0 +1,155 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#include "sparse_clique.hh"
+#include "clique.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <iostream>
+
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+namespace
+{
+    struct SparseIncumbent
+    {
+        std::atomic<unsigned> value{ 0 };
+
+        std::mutex mutex;
+        std::vector<int> c;
+    };
+}
+
+auto sparse_clique(const Graph & graph, const Params & params) -> Result
+{
+    std::vector<unsigned> core(graph.size), ordering, position(graph.size);
+    for (unsigned v = 0 ; v < graph.size ; ++v)
+        core[v] = graph.degree(v);
+    core_decomposition(core, ordering, [&] (unsigned v, const auto & f) {
+            for (auto e = graph.offsets[v] ; e < graph.offsets[v + 1] ; ++e)
+                f(graph.neighbours[e]);
+            });
+    for (unsigned i = 0 ; i < graph.size ; ++i)
+        position[ordering[i]] = i;
+
+    SparseIncumbent incumbent;
+    incumbent.value = params.prime;
+
+    std::atomic<unsigned long long> nodes{ 0 };
+    std::list<milliseconds> thread_times;
+    std::mutex thread_times_mutex;
+
+    // Work down the ordering from the end, so the densest parts of the
+    // graph go first. Core numbers only go down from there, so once one
+    // can't beat the incumbent, nothing else can either.
+    std::atomic<unsigned> next{ 0 };
+
+    auto run_thread = [&] {
+        // local[w] says where w is in the current subproblem, if it is
+        std::vector<int> local(graph.size, -1);
+        std::vector<unsigned> members;
+        std::vector<unsigned long long> sub_offsets;
+        std::vector<unsigned> sub_neighbours;
+
+        while (! params.abort->load()) {
+            unsigned i = next++;
+            if (i >= graph.size)
+                break;
+
+            unsigned v = ordering[graph.size - i - 1];
+            unsigned value = incumbent.value;
+            if (core[v] + 1 <= value || (params.decide > 0 && value >= params.decide))
+                break;
+
+            // later neighbours which might still be in a better clique
+            members.clear();
+            for (auto e = graph.offsets[v] ; e < graph.offsets[v + 1] ; ++e) {
+                unsigned w = graph.neighbours[e];
+                if (position[w] > position[v] && core[w] >= value)
+                    members.push_back(w);
+            }
+            if (members.size() + 1 <= value)
+                continue;
+
+            // neighbours are in ascending order, and so are our members, so
+            // local numbers keep adjacency lists in order too
+            for (unsigned m = 0 ; m < members.size() ; ++m)
+                local[members[m]] = m;
+            sub_offsets.assign(1, 0);
+            sub_neighbours.clear();
+            for (auto & w : members) {
+                for (auto e = graph.offsets[w] ; e < graph.offsets[w + 1] ; ++e)
+                    if (-1 != local[graph.neighbours[e]])
+                        sub_neighbours.push_back(local[graph.neighbours[e]]);
+                sub_offsets.push_back(sub_neighbours.size());
+            }
+            for (auto & w : members)
+                local[w] = -1;
+
+            Graph subgraph;
+            subgraph.size = members.size();
+            subgraph.offsets = sub_offsets.data();
+            subgraph.neighbours = sub_neighbours.data();
+
+            // we need a clique of the incumbent's size, not including v
+            Params subparams;
+            subparams.abort = params.abort;
+            subparams.start_time = params.start_time;
+            subparams.initial_ordering = params.initial_ordering;
+            subparams.how_much_sorting = params.how_much_sorting;
+            subparams.threshold_colouring = params.threshold_colouring;
+            subparams.infra_chromatic = params.infra_chromatic;
+            subparams.iterate_backwards = params.iterate_backwards;
+            subparams.runtime_sized_bitsets = params.runtime_sized_bitsets;
+            subparams.prime = value > 0 ? value - 1 : 0;
+            subparams.decide = params.decide > 0 ? params.decide - 1 : 0;
+            subparams.print_incumbents = false;
+
+            auto subresult = clique(subgraph, subparams);
+            nodes += subresult.nodes;
+
+            if (subresult.clique.size() + 1 > incumbent.value) {
+                std::unique_lock<std::mutex> lock(incumbent.mutex);
+                if (subresult.clique.size() + 1 > incumbent.c.size()) {
+                    incumbent.c.assign(1, v);
+                    for (auto & m : subresult.clique)
+                        incumbent.c.push_back(members[m]);
+                    incumbent.value = std::max<unsigned>(incumbent.value, incumbent.c.size());
+                    if (params.print_incumbents)
+                        std::cout << "-- " << incumbent.c.size()
+                            << " " << nodes
+                            << " " << duration_cast<milliseconds>(steady_clock::now() - params.start_time).count()
+                            << std::endl;
+                }
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(thread_times_mutex);
+        thread_times.push_back(duration_cast<milliseconds>(steady_clock::now() - params.start_time));
+    };
+
+    if (params.n_threads > 1) {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0 ; t < params.n_threads ; ++t)
+            threads.emplace_back(run_thread);
+        for (auto & t : threads)
+            t.join();
+    }
+    else
+        run_thread();
+
+    Result result;
+    result.nodes = nodes;
+    result.clique.insert(incumbent.c.begin(), incumbent.c.end());
+
+    if (params.n_threads > 1) {
+        result.times.push_back(duration_cast<milliseconds>(steady_clock::now() - params.start_time));
+        result.times.insert(result.times.end(), thread_times.begin(), thread_times.end());
+    }
+
+    return result;
+}
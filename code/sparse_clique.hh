@@ -0,0 +1,19 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+#ifndef CODE_GUARD_SPARSE_CLIQUE_HH
+#define CODE_GUARD_SPARSE_CLIQUE_HH 1
+
+#include "graph.hh"
+#include "params.hh"
+#include "result.hh"
+
+/**
+ * Maximum clique for large sparse graphs, where an adjacency matrix won't
+ * fit. We find the core number of every vertex, and for each vertex v
+ * which might still be in a better clique, we solve the subgraph induced
+ * by its neighbours which come after it in a degeneracy ordering using
+ * clique(). The graph must be in adjacency list form.
+ */
+auto sparse_clique(const Graph & graph, const Params & params) -> Result;
+
+#endif
@@ -36,6 +36,12 @@ struct IndexSizes
             std::false_type>::type>::type;
 };
 
+template <>
+struct IndexSizes<runtime_sized_words>
+{
+    using Type = unsigned;
+};
+
 template <template <unsigned, typename> class Algorithm_, typename Result_, typename Graph_, unsigned... sizes_, typename... Params_>
 auto select_graph_size(const GraphSizes<sizes_...> &, const Graph_ & graph, Params_ && ... params) -> Result_
 {
@@ -49,9 +55,11 @@ auto select_graph_size(const GraphSizes<sizes_...> &, const Graph_ & graph, Para
 }
 
 template <template <unsigned, typename> class Algorithm_, typename Result_, typename Graph_, typename... Params_>
-auto select_graph_size(const NoMoreGraphSizes &, const Graph_ &, Params_ && ...) -> Result_
+auto select_graph_size(const NoMoreGraphSizes &, const Graph_ & graph, Params_ && ... params) -> Result_
 {
-    throw GraphTooBig();
+    Algorithm_<runtime_sized_words, typename IndexSizes<runtime_sized_words>::Type> algorithm{
+        graph, std::forward<Params_>(params)... };
+    return algorithm.run();
 }
 
 using AllGraphSizes = GraphSizes<1, 2, 3, 4, 5, 6, 7, 8, 16, 20, 24, 28, 32, 64, 128, 256, 512, 1024>;